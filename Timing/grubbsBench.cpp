@@ -0,0 +1,184 @@
+// Native benchmark for the C++ core, without the Python binding in the way.
+// Prints one JSON document with the median / min time of every case so runs
+// can be diffed or tracked for regressions.
+//
+//   grubbsbench [--max-size N] [--reps N] [--alpha A] [--seed S] [--out FILE]
+
+#include "mainFunctions.hpp"
+#include "grubbsStats.hpp"
+#include "simdKernels.hpp"
+#include "threadPool.hpp"
+#include "testUtil.hpp"         // makeContaminatedData, shared with the tests
+#include <algorithm>
+#include <chrono>
+#include <cstdint>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <string>
+#include <vector>
+
+static const double kOutlierFractions[] = {0.0, 0.001, 0.01, 0.05, 0.1};
+
+struct BenchOptions {
+    size_t maxSize = 10000000;
+    size_t reps = 0;          // 0 = scale with the input size
+    double alpha = 0.05;
+    uint64_t seed = 42;
+    const char* outPath = nullptr;
+};
+
+// About 5M touched points per case, at least 3 and at most 1000 repetitions
+static size_t repsFor(const BenchOptions& options, size_t size) {
+    if (options.reps) return options.reps;
+    return std::min<size_t>(1000, std::max<size_t>(3, 5000000 / size));
+}
+
+struct Timing {
+    double median;
+    double min;
+};
+
+template <typename Fn>
+static Timing timeReps(size_t reps, Fn&& fn) {
+    std::vector<double> seconds(reps);
+    for (size_t r = 0; r < reps; r++) {
+        auto start = std::chrono::steady_clock::now();
+        fn();
+        seconds[r] = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+    }
+    std::sort(seconds.begin(), seconds.end());
+    return {seconds[reps / 2], seconds[0]};
+}
+
+static void printResult(FILE* out, bool* first, const char* function, size_t size,
+                        double fraction, size_t reps, Timing timing, const std::string& extra) {
+    std::fprintf(out, "%s\n    {\"function\": \"%s\", \"size\": %zu, \"outlierFraction\": %g, "
+                 "\"reps\": %zu, \"medianSeconds\": %.9g, \"minSeconds\": %.9g%s}",
+                 *first ? "" : ",", function, size, fraction, reps, timing.median, timing.min,
+                 extra.c_str());
+    *first = false;
+}
+
+// Stats of one extra, instrumented run; kept out of the timed loop
+static std::string statsFields(const GrubbsStats& stats, size_t outliers) {
+    char buf[512];
+    std::snprintf(buf, sizeof(buf),
+                  ", \"outliers\": %zu, \"scanIterations\": %zu, \"sortedIterations\": %zu, "
+                  "\"quantileSeconds\": %.9g, \"scanSeconds\": %.9g, \"sortSeconds\": %.9g, "
+                  "\"bytesAllocated\": %zu",
+                  outliers, stats.scanIterations, stats.sortedIterations, stats.quantileSeconds,
+                  stats.scanSeconds, stats.sortSeconds, stats.bytesAllocated);
+    return buf;
+}
+
+static bool parseArgs(int argc, char** argv, BenchOptions* options) {
+    for (int i = 1; i < argc; i++) {
+        const char* arg = argv[i];
+        const char* value = (i + 1 < argc) ? argv[i + 1] : nullptr;
+        if (!value) {
+            std::fprintf(stderr, "Error: missing value for %s\n", arg);
+            return false;
+        }
+        if (!std::strcmp(arg, "--max-size")) options->maxSize = std::strtoull(value, nullptr, 10);
+        else if (!std::strcmp(arg, "--reps")) options->reps = std::strtoull(value, nullptr, 10);
+        else if (!std::strcmp(arg, "--alpha")) options->alpha = std::strtod(value, nullptr);
+        else if (!std::strcmp(arg, "--seed")) options->seed = std::strtoull(value, nullptr, 10);
+        else if (!std::strcmp(arg, "--out")) options->outPath = value;
+        else {
+            std::fprintf(stderr, "Error: unknown option %s\n", arg);
+            return false;
+        }
+        i++;
+    }
+    return true;
+}
+
+int main(int argc, char** argv) {
+    BenchOptions options;
+    if (!parseArgs(argc, argv, &options)) {
+        std::fprintf(stderr, "usage: %s [--max-size N] [--reps N] [--alpha A] [--seed S] "
+                     "[--out FILE]\n", argv[0]);
+        return 2;
+    }
+    FILE* out = options.outPath ? std::fopen(options.outPath, "w") : stdout;
+    if (!out) {
+        std::fprintf(stderr, "Error: cannot open %s\n", options.outPath);
+        return 1;
+    }
+
+    static const char* simdNames[] = {"scalar", "avx2", "avx512"};
+    std::fprintf(out, "{\n  \"benchmark\": \"grubbsbench\",\n  \"alpha\": %g,\n  \"seed\": %llu,\n"
+                 "  \"simd\": \"%s\",\n  \"threads\": %zu,\n  \"results\": [",
+                 options.alpha, (unsigned long long)options.seed,
+                 simdNames[activeSimdLevel()], globalThreadPool().size());
+
+    bool first = true;
+    std::vector<double> values, zscores;
+    std::vector<float> floatValues;
+    std::vector<unsigned char> mask;
+    GrubbsWorkspace workspace;
+    for (size_t size = 1000; size <= options.maxSize; size *= 10) {
+        size_t reps = repsFor(options, size);
+        zscores.resize(size);
+        mask.resize(size);
+
+        // calcTDist is what the critical-value cache avoids; time a single quantile
+        Timing tdist = timeReps(reps, [&] {
+            volatile double t = calcTDist(options.alpha, size);
+            (void)t;
+        });
+        printResult(out, &first, "calcTDist", size, 0.0, reps, tdist, "");
+
+        for (double fraction : kOutlierFractions) {
+            values = makeContaminatedData(size, fraction, options.seed);
+
+            Timing meanStd = timeReps(reps, [&] {
+                double meanValue;
+                volatile double sd = calcMeanStdDev(values.data(), size, &meanValue);
+                (void)sd;
+            });
+            printResult(out, &first, "calcMeanStdDev", size, fraction, reps, meanStd, "");
+
+            Timing noOutlier = timeReps(reps, [&] {
+                performNoOutlier(values.data(), size, zscores.data(), nullptr, nullptr);
+            });
+            printResult(out, &first, "performNoOutlier", size, fraction, reps, noOutlier, "");
+
+            static const GrubbsMode modes[] = {GRUBBS_MODE_AUTO, GRUBBS_MODE_SCAN, GRUBBS_MODE_SORTED};
+            static const char* modeNames[] = {"performGrubbs/auto", "performGrubbs/scan",
+                                              "performGrubbs/sorted"};
+            for (size_t m = 0; m < 3; m++) {
+                // "scan" costs one O(n) pass per outlier; skip cases beyond ~1e9 point visits
+                if (modes[m] == GRUBBS_MODE_SCAN && fraction * size * size > 1e9) continue;
+                size_t modeReps = (modes[m] == GRUBBS_MODE_SCAN) ? std::min<size_t>(reps, 3) : reps;
+
+                Timing grubbs = timeReps(modeReps, [&] {
+                    performGrubbs(values.data(), size, zscores.data(), options.alpha, mask.data(),
+                                  nullptr, nullptr, modes[m], &workspace);
+                });
+
+                setGrubbsStatsEnabled(true);
+                resetGrubbsStats();
+                performGrubbs(values.data(), size, zscores.data(), options.alpha, mask.data(),
+                              nullptr, nullptr, modes[m], &workspace);
+                setGrubbsStatsEnabled(false);
+                size_t outliers = std::count(mask.begin(), mask.end(), 1);
+                printResult(out, &first, modeNames[m], size, fraction, modeReps, grubbs,
+                            statsFields(threadGrubbsStats(), outliers));
+            }
+
+            // Same data read as float32: half the bytes per pass, no conversion copy
+            floatValues.assign(values.begin(), values.end());
+            Timing grubbsFloat = timeReps(reps, [&] {
+                performGrubbs(floatValues.data(), size, zscores.data(), options.alpha, mask.data(),
+                              nullptr, nullptr, GRUBBS_MODE_AUTO, &workspace);
+            });
+            printResult(out, &first, "performGrubbs/float32", size, fraction, reps, grubbsFloat, "");
+            std::fflush(out);
+        }
+    }
+    std::fprintf(out, "\n  ]\n}\n");
+    if (out != stdout) std::fclose(out);
+    return 0;
+}
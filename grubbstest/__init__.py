@@ -1,3 +1,27 @@
-from .fastgrubbstest import run_Grubbs, run_NoOutlier
+from .fastgrubbstest import (
+    run_Grubbs,
+    run_NoOutlier,
+    run_GrubbsArray,
+    run_NoOutlierArray,
+    run_GrubbsBatch,
+    run_GrubbsFile,
+    GrubbsStream,
+    GrubbsEngine,
+    precompute_CriticalValues,
+    enable_Stats,
+    last_Stats,
+)
 
-__all__ = ["run_Grubbs", "run_NoOutlier"]
+__all__ = [
+    "run_Grubbs",
+    "run_NoOutlier",
+    "run_GrubbsArray",
+    "run_NoOutlierArray",
+    "run_GrubbsBatch",
+    "run_GrubbsFile",
+    "GrubbsStream",
+    "GrubbsEngine",
+    "precompute_CriticalValues",
+    "enable_Stats",
+    "last_Stats",
+]
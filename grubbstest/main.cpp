@@ -1,84 +1,518 @@
 #include <nanobind/nanobind.h>
+#include <nanobind/ndarray.h>
 #include <nanobind/stl/string.h>
+#include <nanobind/stl/vector.h>
 #include <memory>
 #include <vector>
+#include <stdexcept>
 #include <string>
+#include <limits>
+#include <algorithm>
+#include <cstdint>
 #include "../helperfuncs/mainFunctions.hpp"
+#include "../helperfuncs/criticalValues.hpp"
+#include "../helperfuncs/batchGrubbs.hpp"
+#include "../helperfuncs/streamingGrubbs.hpp"
+#include "../helperfuncs/grubbsEngine.hpp"
+#include "../helperfuncs/grubbsStats.hpp"
+#include "../helperfuncs/fileGrubbs.hpp"
 
 namespace nb = nanobind;
 
-// run_Grubbs(data: dict, alpha: float) -> dict
-// data: {str: number}, returns {str: [number, zscore]}
-nb::dict run_Grubbs(nb::dict data, double alpha = 0.05) {
-    size_t n = data.size();
-    if (n == 0) return nb::dict();
+// Any C-contiguous float64 buffer (NumPy array, memoryview, array.array, ...)
+// is accepted without a copy.
+using InputArray = nb::ndarray<const double, nb::ndim<1>, nb::c_contig, nb::device::cpu>;
 
-    std::vector<std::string> keys;
-    keys.reserve(n);
-    std::shared_ptr<double[]> values(new double[n]);
-    std::shared_ptr<double[]> zscores(new double[n]);
+// Same for the other accepted dtypes (float32, int32, int64), read without a
+// float64 conversion pass
+template <typename T>
+using TypedArray = nb::ndarray<const T, nb::ndim<1>, nb::c_contig, nb::device::cpu>;
 
-    size_t i = 0;
-    for (auto item : data) {
-        keys.push_back(nb::cast<std::string>(item.first));
-        values[i] = nb::cast<double>(item.second);
-        i++;
+// Writable float64 buffer, for results written into caller-owned memory. Always
+// taken without conversion: a converted copy would receive the writes and the
+// caller's array would silently stay unchanged.
+using MutableArray = nb::ndarray<double, nb::ndim<1>, nb::c_contig, nb::device::cpu>;
+
+template <typename T>
+using OutputArray = nb::ndarray<nb::numpy, T, nb::ndim<1>>;
+
+// Allocates a NumPy-owned 1-D array that the C++ kernels write into directly.
+template <typename T>
+static OutputArray<T> makeArray(size_t n, T** data) {
+    T* buf = new T[n];
+    recordGrubbsAllocation(n * sizeof(T));
+    nb::capsule owner(buf, [](void* p) noexcept { delete[] (T*) p; });
+    *data = buf;
+    return OutputArray<T>(buf, {n}, owner);
+}
+
+static GrubbsMode parseMode(const std::string& mode) {
+    if (mode == "auto") return GRUBBS_MODE_AUTO;
+    if (mode == "scan") return GRUBBS_MODE_SCAN;
+    if (mode == "sorted") return GRUBBS_MODE_SORTED;
+    throw std::invalid_argument("mode must be 'auto', 'scan' or 'sorted'");
+}
+
+static GrubbsTail parseTail(const std::string& tail) {
+    if (tail == "two-sided") return GRUBBS_TWO_SIDED;
+    if (tail == "upper") return GRUBBS_UPPER;
+    if (tail == "lower") return GRUBBS_LOWER;
+    throw std::invalid_argument("tail must be 'two-sided', 'upper' or 'lower'");
+}
+
+// Picks the performGrubbs instantiation for a tail chosen at run time
+template <typename T>
+static int performGrubbsTail(GrubbsTail tail, const T* values, size_t size, double* zscores,
+                             double alpha, unsigned char* outlierMask, double* cleanMean,
+                             double* cleanSd, GrubbsMode mode) {
+    switch (tail) {
+    case GRUBBS_UPPER:
+        return performGrubbs<T, GRUBBS_UPPER>(values, size, zscores, alpha, outlierMask,
+                                              cleanMean, cleanSd, mode);
+    case GRUBBS_LOWER:
+        return performGrubbs<T, GRUBBS_LOWER>(values, size, zscores, alpha, outlierMask,
+                                              cleanMean, cleanSd, mode);
+    default:
+        return performGrubbs<T>(values, size, zscores, alpha, outlierMask,
+                                cleanMean, cleanSd, mode);
     }
+}
 
-    std::shared_ptr<double[]> finalValues;
-    size_t finalSize = 0;
+// Appends the dict's keys and values. Keys are held as Python objects so they
+// are handed back untouched.
+static size_t unpackDict(nb::dict data, std::vector<nb::object>& keys,
+                         std::vector<double>& values) {
+    size_t n = data.size();
+    recordGrubbsAllocation(n * (sizeof(nb::object) + sizeof(double)));
+    keys.reserve(keys.size() + n);
+    values.reserve(values.size() + n);
 
-    int ret = performGrubbs(values, n, finalValues, &finalSize, zscores, alpha);
-    if (ret != 0) {
-        throw std::runtime_error("Grubbs test failed");
+    for (auto item : data) {
+        keys.push_back(nb::borrow(item.first));
+        values.push_back(nb::cast<double>(item.second));
     }
+    return n;
+}
 
+static nb::dict packDict(const nb::object* keys, const double* values, const double* zscores,
+                         size_t n) {
     nb::dict result;
     for (size_t j = 0; j < n; j++) {
         nb::list entry;
         entry.append(values[j]);
         entry.append(zscores[j]);
-        result[nb::cast(keys[j])] = entry;
+        result[keys[j]] = entry;
     }
     return result;
 }
 
+// run_Grubbs(data: dict, alpha: float, mode: str) -> dict
+// data: {key: number}, returns {key: [number, zscore]}
+nb::dict run_Grubbs(nb::dict data, double alpha = 0.05, const std::string& mode = "auto") {
+    resetGrubbsStats();
+    GrubbsMode grubbsMode = parseMode(mode);
+    if (data.size() == 0) return nb::dict();
+
+    std::vector<nb::object> keys;
+    std::vector<double> values;
+    size_t n = unpackDict(data, keys, values);
+    std::unique_ptr<double[]> zscores(new double[n]);
+    recordGrubbsAllocation(n * sizeof(double));
+
+    int ret = performGrubbs(values.data(), n, zscores.get(), alpha, nullptr, nullptr, nullptr,
+                            grubbsMode);
+    if (ret != 0) {
+        throw std::runtime_error("Grubbs test failed");
+    }
+    return packDict(keys.data(), values.data(), zscores.get(), n);
+}
+
 // run_NoOutlier(data: dict) -> dict
-// data: {str: number}, returns {str: [number, zscore]}
+// data: {key: number}, returns {key: [number, zscore]}
 nb::dict run_NoOutlier(nb::dict data) {
-    size_t n = data.size();
-    if (n == 0) return nb::dict();
+    resetGrubbsStats();
+    if (data.size() == 0) return nb::dict();
 
-    std::vector<std::string> keys;
-    keys.reserve(n);
-    std::shared_ptr<double[]> values(new double[n]);
-    std::shared_ptr<double[]> zscores(new double[n]);
+    std::vector<nb::object> keys;
+    std::vector<double> values;
+    size_t n = unpackDict(data, keys, values);
+    std::unique_ptr<double[]> zscores(new double[n]);
+    recordGrubbsAllocation(n * sizeof(double));
 
-    size_t i = 0;
-    for (auto item : data) {
-        keys.push_back(nb::cast<std::string>(item.first));
-        values[i] = nb::cast<double>(item.second);
-        i++;
+    int ret = performNoOutlier(values.data(), n, zscores.get(), nullptr, nullptr);
+    if (ret != 0) {
+        throw std::runtime_error("NoOutlier test failed");
     }
+    return packDict(keys.data(), values.data(), zscores.get(), n);
+}
 
-    int ret = performNoOutlier(values, n, zscores);
+// run_GrubbsArray(values: ndarray[float64|float32|int32|int64], alpha: float,
+//                 full_output: bool, mode: str, tail: str)
+// returns zscores, or (zscores, outlier_mask, clean_mean, clean_sd) if full_output
+template <typename T>
+nb::object run_GrubbsArray(TypedArray<T> values, double alpha = 0.05, bool full_output = false,
+                           const std::string& mode = "auto",
+                           const std::string& tail = "two-sided") {
+    resetGrubbsStats();
+    GrubbsMode grubbsMode = parseMode(mode);
+    GrubbsTail grubbsTail = parseTail(tail);
+    size_t n = values.shape(0);
+    double* zscores;
+    bool* mask = nullptr;
+    auto zArray = makeArray<double>(n, &zscores);
+    OutputArray<bool> maskArray;
+    if (full_output) maskArray = makeArray<bool>(n, &mask);
+    if (n == 0) {
+        if (!full_output) return nb::cast(zArray);
+        return nb::make_tuple(zArray, maskArray, 0.0, 0.0);
+    }
+
+    double cleanMean = 0.0, cleanSd = 0.0;
+    int ret;
+    {
+        nb::gil_scoped_release release;
+        ret = performGrubbsTail(grubbsTail, values.data(), n, zscores, alpha,
+                                reinterpret_cast<unsigned char*>(mask), &cleanMean, &cleanSd,
+                                grubbsMode);
+    }
+    if (ret != 0) {
+        throw std::runtime_error("Grubbs test failed");
+    }
+
+    if (!full_output) return nb::cast(zArray);
+    return nb::make_tuple(zArray, maskArray, cleanMean, cleanSd);
+}
+
+// run_NoOutlierArray(values: ndarray[float64|float32|int32|int64], full_output: bool)
+// returns zscores, or (zscores, mean, sd) if full_output
+template <typename T>
+nb::object run_NoOutlierArray(TypedArray<T> values, bool full_output = false) {
+    resetGrubbsStats();
+    size_t n = values.shape(0);
+    double* zscores;
+    auto zArray = makeArray<double>(n, &zscores);
+    if (n == 0) {
+        if (!full_output) return nb::cast(zArray);
+        return nb::make_tuple(zArray, 0.0, 0.0);
+    }
+
+    double meanValue = 0.0, sdValue = 0.0;
+    int ret;
+    {
+        nb::gil_scoped_release release;
+        ret = performNoOutlier(values.data(), n, zscores, &meanValue, &sdValue);
+    }
     if (ret != 0) {
         throw std::runtime_error("NoOutlier test failed");
     }
 
+    if (!full_output) return nb::cast(zArray);
+    return nb::make_tuple(zArray, meanValue, sdValue);
+}
+
+using OffsetArray = nb::ndarray<const int64_t, nb::ndim<1>, nb::c_contig, nb::device::cpu>;
+
+// run_GrubbsBatch(values: ndarray[float64], offsets: ndarray[int64], alpha: float, mode: str)
+// Group g is values[offsets[g]:offsets[g+1]]. Returns flat arrays
+// (zscores, outlier_mask, clean_means, clean_sds, ok); failed groups have ok=False and NaNs.
+nb::tuple run_GrubbsBatch(InputArray values, OffsetArray offsets, double alpha = 0.05,
+                          const std::string& mode = "auto") {
+    resetGrubbsStats();
+    GrubbsMode grubbsMode = parseMode(mode);
+    size_t n = values.shape(0);
+    size_t groupCount = offsets.shape(0) > 0 ? offsets.shape(0) - 1 : 0;
+
+    std::vector<size_t> groupOffsets(groupCount + 1, 0);
+    for (size_t g = 0; g < offsets.shape(0); g++) {
+        int64_t offset = offsets.data()[g];
+        if (offset < 0 || (size_t)offset > n) {
+            throw std::invalid_argument("offsets must lie within [0, len(values)]");
+        }
+        groupOffsets[g] = (size_t)offset;
+    }
+
+    double *zscores, *cleanMeans, *cleanSds;
+    bool *mask, *ok;
+    auto zArray = makeArray<double>(n, &zscores);
+    auto maskArray = makeArray<bool>(n, &mask);
+    auto meanArray = makeArray<double>(groupCount, &cleanMeans);
+    auto sdArray = makeArray<double>(groupCount, &cleanSds);
+    auto okArray = makeArray<bool>(groupCount, &ok);
+    std::fill(zscores, zscores + n, std::numeric_limits<double>::quiet_NaN());
+    std::fill(mask, mask + n, false);
+
+    int ret;
+    {
+        nb::gil_scoped_release release;
+        ret = performGrubbsBatch(values.data(), groupOffsets.data(), groupCount, alpha, zscores,
+                                 reinterpret_cast<unsigned char*>(mask), cleanMeans, cleanSds,
+                                 reinterpret_cast<unsigned char*>(ok), grubbsMode);
+    }
+    if (ret != 0) {
+        throw std::invalid_argument("offsets must be non-decreasing");
+    }
+    return nb::make_tuple(zArray, maskArray, meanArray, sdArray, okArray);
+}
+
+// run_GrubbsBatch(groups: dict, alpha: float, mode: str) -> dict
+// groups: {group: {key: number}}, returns {group: {key: [number, zscore]}}
+nb::dict run_GrubbsBatchDict(nb::dict groups, double alpha = 0.05, const std::string& mode = "auto") {
+    resetGrubbsStats();
+    GrubbsMode grubbsMode = parseMode(mode);
+    std::vector<nb::object> groupKeys, keys;
+    std::vector<double> values;
+    std::vector<size_t> offsets(1, 0);
+    for (auto item : groups) {
+        groupKeys.push_back(nb::borrow(item.first));
+        unpackDict(nb::cast<nb::dict>(item.second), keys, values);
+        offsets.push_back(values.size());
+    }
+
+    size_t groupCount = groupKeys.size();
+    std::unique_ptr<double[]> zscores(new double[values.size()]);
+    recordGrubbsAllocation(values.size() * sizeof(double));
+    {
+        nb::gil_scoped_release release;
+        performGrubbsBatch(values.data(), offsets.data(), groupCount, alpha, zscores.get(),
+                           nullptr, nullptr, nullptr, nullptr, grubbsMode);
+    }
+
     nb::dict result;
-    for (size_t j = 0; j < n; j++) {
-        nb::list entry;
-        entry.append(values[j]);
-        entry.append(zscores[j]);
-        result[nb::cast(keys[j])] = entry;
+    for (size_t g = 0; g < groupCount; g++) {
+        size_t begin = offsets[g];
+        result[groupKeys[g]] = packDict(keys.data() + begin, values.data() + begin,
+                                        zscores.get() + begin, offsets[g + 1] - begin);
     }
     return result;
 }
 
+// GrubbsStream.push(value: float) -> (zscore, is_outlier)
+// zscore is NaN while the window is too small or flat to test
+static nb::tuple streamPush(GrubbsStream& stream, double value) {
+    double zscore;
+    bool isOutlier;
+    stream.push(value, &zscore, &isOutlier);
+    return nb::make_tuple(zscore, isOutlier);
+}
+
+// GrubbsStream.push_many(values: ndarray[float64]) -> (zscores, outlier_mask)
+static nb::tuple streamPushMany(GrubbsStream& stream, InputArray values) {
+    size_t n = values.shape(0);
+    double* zscores;
+    bool* mask;
+    auto zArray = makeArray<double>(n, &zscores);
+    auto maskArray = makeArray<bool>(n, &mask);
+    stream.pushMany(values.data(), n, zscores, reinterpret_cast<unsigned char*>(mask));
+    return nb::make_tuple(zArray, maskArray);
+}
+
+// GrubbsEngine.run(values: ndarray[float64], alpha: float, out: ndarray[float64] | None)
+// returns zscores; with out, writes into it and returns it so a loop allocates nothing
+static nb::object engineRun(GrubbsEngine& engine, InputArray values, double alpha,
+                            nb::object out) {
+    resetGrubbsStats();
+    size_t n = values.shape(0);
+    double* zscores;
+    nb::object result;
+    if (out.is_none()) {
+        result = nb::cast(makeArray<double>(n, &zscores));
+    } else {
+        MutableArray outArray;
+        if (!nb::try_cast<MutableArray>(out, outArray, false)) {
+            throw nb::type_error("out must be a writable, C-contiguous float64 array");
+        }
+        if (outArray.shape(0) != n) {
+            throw std::invalid_argument("out must have the same length as values");
+        }
+        zscores = outArray.data();
+        result = out;
+    }
+    if (n == 0) return result;
+
+    // The engine's lock is taken with the GIL released, so a thread waiting for
+    // a shared engine does not stall the other Python threads
+    int ret;
+    {
+        nb::gil_scoped_release release;
+        ret = engine.run(values.data(), n, zscores, alpha);
+    }
+    if (ret != 0) {
+        throw std::runtime_error("Grubbs test failed");
+    }
+    return result;
+}
+
+// GrubbsEngine.run_inplace(values: ndarray[float64], alpha: float) -> (clean_size, clean_mean, clean_sd)
+// Reorders values so the clean_size survivors come first and the outliers last
+static nb::tuple engineRunInPlace(GrubbsEngine& engine, MutableArray values, double alpha) {
+    resetGrubbsStats();
+    size_t n = values.shape(0);
+    if (n == 0) return nb::make_tuple(0, 0.0, 0.0);
+
+    size_t cleanSize = 0;
+    double cleanMean = 0.0, cleanSd = 0.0;
+    int ret;
+    {
+        nb::gil_scoped_release release;
+        ret = engine.runInPlace(values.data(), n, alpha, &cleanSize, &cleanMean, &cleanSd);
+    }
+    if (ret != 0) {
+        throw std::runtime_error("Grubbs test failed");
+    }
+    return nb::make_tuple(cleanSize, cleanMean, cleanSd);
+}
+
+static GrubbsFileFormat parseFileFormat(const std::string& format) {
+    if (format == "float64") return GRUBBS_FILE_FLOAT64;
+    if (format == "float32") return GRUBBS_FILE_FLOAT32;
+    if (format == "header") return GRUBBS_FILE_HEADER;
+    throw std::invalid_argument("format must be 'float64', 'float32' or 'header'");
+}
+
+// run_GrubbsFile(path: str | PathLike, zscore_path: str | PathLike | None, alpha: float,
+//                format: str, max_candidates: int) -> (size, clean_size, clean_mean, clean_sd)
+// Memory-maps the input instead of loading it; z-scores go to zscore_path as raw float64
+nb::tuple run_GrubbsFile(nb::object path, nb::object zscore_path, double alpha = 0.05,
+                         const std::string& format = "float64",
+                         size_t max_candidates = kFileCandidates) {
+    resetGrubbsStats();
+    GrubbsFileFormat fileFormat = parseFileFormat(format);
+    if (max_candidates == 0) {
+        throw std::invalid_argument("max_candidates must be positive");
+    }
+    std::string inputPath = nb::str(path).c_str();
+    std::string zscorePath = zscore_path.is_none() ? "" : nb::str(zscore_path).c_str();
+
+    size_t size = 0, cleanSize = 0;
+    double cleanMean = 0.0, cleanSd = 0.0;
+    int ret;
+    {
+        nb::gil_scoped_release release;
+        ret = performGrubbsFile(inputPath.c_str(), fileFormat,
+                                zscorePath.empty() ? nullptr : zscorePath.c_str(), alpha,
+                                &size, &cleanSize, &cleanMean, &cleanSd, max_candidates);
+    }
+    if (ret != 0) {
+        throw std::runtime_error("Grubbs file test failed");
+    }
+    return nb::make_tuple(size, cleanSize, cleanMean, cleanSd);
+}
+
+// enable_Stats(enabled: bool) -> None
+// Turns on the per-call counters reported by last_Stats (off by default)
+void enable_Stats(bool enabled) {
+    setGrubbsStatsEnabled(enabled);
+}
+
+// last_Stats() -> dict
+// Counters of the most recent call on this thread; zeros while stats are disabled
+nb::dict last_Stats() {
+    const GrubbsStats& stats = threadGrubbsStats();
+    nb::dict result;
+    result["enabled"] = grubbsStatsEnabled();
+    result["calls"] = stats.calls;
+    result["iterations"] = stats.scanIterations + stats.sortedIterations;
+    result["scan_iterations"] = stats.scanIterations;
+    result["sorted_iterations"] = stats.sortedIterations;
+    result["total_seconds"] = stats.totalSeconds;
+    result["quantile_seconds"] = stats.quantileSeconds;
+    result["scan_seconds"] = stats.scanSeconds;
+    result["sort_seconds"] = stats.sortSeconds;
+    result["bytes_allocated"] = stats.bytesAllocated;
+    return result;
+}
+
+// precompute_CriticalValues(alphas: list[float]) -> None
+// Builds the critical-value table for each alpha ahead of the first test
+void precompute_CriticalValues(const std::vector<double>& alphas) {
+    nb::gil_scoped_release release;
+    precomputeCriticalValues(alphas.data(), alphas.size());
+}
+
 NB_MODULE(fastgrubbstest, m) {
     m.def("run_Grubbs", &run_Grubbs, nb::arg("data"), nb::arg("alpha") = 0.05,
+          nb::arg("mode") = "auto",
           "Grubbs test with iterative outlier removal. Returns {id: [value, zscore]}.");
     m.def("run_NoOutlier", &run_NoOutlier, nb::arg("data"),
           "Standard z-score with no outlier removal. Returns {id: [value, zscore]}.");
+    // float64 is registered first: nanobind tries every overload without
+    // conversions before falling back to converting the input to float64
+    m.def("run_GrubbsArray", &run_GrubbsArray<double>, nb::arg("values"), nb::arg("alpha") = 0.05,
+          nb::arg("full_output") = false, nb::arg("mode") = "auto", nb::arg("tail") = "two-sided",
+          "Grubbs test on a contiguous float64, float32, int32 or int64 array without copying. "
+          "tail is 'two-sided', 'upper' or 'lower'. Returns zscores, or "
+          "(zscores, outlier_mask, clean_mean, clean_sd) when full_output is set.");
+    m.def("run_GrubbsArray", &run_GrubbsArray<float>, nb::arg("values"), nb::arg("alpha") = 0.05,
+          nb::arg("full_output") = false, nb::arg("mode") = "auto", nb::arg("tail") = "two-sided");
+    m.def("run_GrubbsArray", &run_GrubbsArray<int32_t>, nb::arg("values"), nb::arg("alpha") = 0.05,
+          nb::arg("full_output") = false, nb::arg("mode") = "auto", nb::arg("tail") = "two-sided");
+    m.def("run_GrubbsArray", &run_GrubbsArray<int64_t>, nb::arg("values"), nb::arg("alpha") = 0.05,
+          nb::arg("full_output") = false, nb::arg("mode") = "auto", nb::arg("tail") = "two-sided");
+    m.def("run_NoOutlierArray", &run_NoOutlierArray<double>, nb::arg("values"),
+          nb::arg("full_output") = false,
+          "Standard z-score on a contiguous float64, float32, int32 or int64 array without "
+          "copying. Returns zscores, or (zscores, mean, sd) when full_output is set.");
+    m.def("run_NoOutlierArray", &run_NoOutlierArray<float>, nb::arg("values"),
+          nb::arg("full_output") = false);
+    m.def("run_NoOutlierArray", &run_NoOutlierArray<int32_t>, nb::arg("values"),
+          nb::arg("full_output") = false);
+    m.def("run_NoOutlierArray", &run_NoOutlierArray<int64_t>, nb::arg("values"),
+          nb::arg("full_output") = false);
+    m.def("run_GrubbsBatch", &run_GrubbsBatch, nb::arg("values"), nb::arg("offsets"),
+          nb::arg("alpha") = 0.05, nb::arg("mode") = "auto",
+          "Grubbs test on every group values[offsets[g]:offsets[g+1]] in parallel with the GIL "
+          "released. Returns (zscores, outlier_mask, clean_means, clean_sds, ok).");
+    m.def("run_GrubbsBatch", &run_GrubbsBatchDict, nb::arg("groups"), nb::arg("alpha") = 0.05,
+          nb::arg("mode") = "auto",
+          "Grubbs test on every inner dict of {group: {id: number}} in parallel. "
+          "Returns {group: {id: [value, zscore]}}; failed groups get NaN z-scores.");
+    m.def("run_GrubbsFile", &run_GrubbsFile, nb::arg("path"),
+          nb::arg("zscore_path") = nb::none(), nb::arg("alpha") = 0.05,
+          nb::arg("format") = "float64", nb::arg("max_candidates") = kFileCandidates,
+          "Grubbs test on a memory-mapped binary file without loading it. Writes float64 "
+          "z-scores to zscore_path when given. Returns (size, clean_size, clean_mean, clean_sd).");
+    m.def("precompute_CriticalValues", &precompute_CriticalValues,
+          nb::arg("alphas") = std::vector<double>{0.01, 0.05, 0.1},
+          "Precompute Grubbs critical values for the given alphas so later calls skip the "
+          "t-distribution root finding.");
+    m.def("enable_Stats", &enable_Stats, nb::arg("enabled") = true,
+          "Collect per-call counters (iterations, time in critical values / scans / sorting, "
+          "bytes allocated). Off by default.");
+    m.def("last_Stats", &last_Stats,
+          "Counters of the most recent call on this thread, as a dict.");
+
+    nb::class_<GrubbsStream>(m, "GrubbsStream",
+          "Grubbs test over a sliding window of the most recent `capacity` points, "
+          "updated incrementally on every push.")
+        .def(nb::init<size_t, double>(), nb::arg("capacity"), nb::arg("alpha") = 0.05)
+        .def("push", &streamPush, nb::arg("value"),
+             "Add a point and test the window. Returns (zscore, is_outlier) for the new point.")
+        .def("push_many", &streamPushMany, nb::arg("values"),
+             "push() each value of a float64 array in turn. Returns (zscores, outlier_mask).")
+        .def("reset", &GrubbsStream::reset, "Empty the window.")
+        .def_prop_ro("size", &GrubbsStream::size)
+        .def_prop_ro("capacity", &GrubbsStream::capacity)
+        .def_prop_ro("alpha", &GrubbsStream::alpha)
+        .def_prop_ro("mean", &GrubbsStream::mean)
+        .def_prop_ro("sd", &GrubbsStream::stdDev);
+
+    nb::class_<GrubbsEngine>(m, "GrubbsEngine",
+          "Reusable Grubbs runner that keeps its scratch memory between calls, so repeated "
+          "tests on similar sizes do not allocate.")
+        .def("__init__", [](GrubbsEngine* engine, const std::string& mode) {
+                 new (engine) GrubbsEngine(parseMode(mode));
+             }, nb::arg("mode") = "auto")
+        .def("run", &engineRun, nb::arg("values"), nb::arg("alpha") = 0.05,
+             nb::arg("out") = nb::none(),
+             "Grubbs test on a contiguous float64 array. Returns zscores, written into `out` "
+             "when a writable, C-contiguous float64 array of the same length is given.")
+        .def("run_inplace", &engineRunInPlace, nb::arg("values").noconvert(),
+             nb::arg("alpha") = 0.05,
+             "Grubbs test that reorders `values` so the survivors come first and the outliers "
+             "last. `values` must be a writable, C-contiguous float64 array; it is never "
+             "converted. Returns (clean_size, clean_mean, clean_sd).")
+        .def("reserve", &GrubbsEngine::reserve, nb::arg("size"),
+             nb::call_guard<nb::gil_scoped_release>(),
+             "Size the scratch memory for `size` points ahead of the first run.")
+        .def_prop_ro("capacity", &GrubbsEngine::capacity);
 }
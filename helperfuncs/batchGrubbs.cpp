@@ -0,0 +1,82 @@
+#include "batchGrubbs.hpp"
+#include "threadPool.hpp"
+#include "grubbsStats.hpp"
+#include <algorithm>
+#include <cstring>
+#include <exception>
+#include <iostream>
+#include <limits>
+#include <vector>
+
+static void runGroup(const double* values, const size_t* offsets, size_t g, double alpha,
+                     double* zscores, unsigned char* outlierMask, double* cleanMeans,
+                     double* cleanSds, unsigned char* groupOk, GrubbsMode mode,
+                     GrubbsWorkspace& workspace) {
+    size_t begin = offsets[g], size = offsets[g + 1] - begin;
+    double cleanMean = std::numeric_limits<double>::quiet_NaN();
+    double cleanSd = cleanMean;
+    unsigned char* mask = outlierMask ? outlierMask + begin : nullptr;
+
+    // groupOk reports failures, so per-group messages would only flood stderr
+    GrubbsQuietErrors quiet;
+    int ret = -1;
+    try {
+        ret = performGrubbs(values + begin, size, zscores + begin, alpha, mask,
+                            &cleanMean, &cleanSd, mode, &workspace);
+    } catch (const std::exception&) {
+        // e.g. the critical value's domain error once removal reaches n = 2
+    }
+
+    if (ret != 0) {
+        std::fill(zscores + begin, zscores + begin + size, std::numeric_limits<double>::quiet_NaN());
+        if (mask) std::memset(mask, 0, size);
+        cleanMean = cleanSd = std::numeric_limits<double>::quiet_NaN();
+    }
+    if (cleanMeans) cleanMeans[g] = cleanMean;
+    if (cleanSds) cleanSds[g] = cleanSd;
+    if (groupOk) groupOk[g] = (ret == 0);
+}
+
+int performGrubbsBatch(const double* values, const size_t* offsets, size_t groupCount,
+                      double alpha, double* zscores, unsigned char* outlierMask,
+                      double* cleanMeans, double* cleanSds, unsigned char* groupOk,
+                      GrubbsMode mode) {
+    if (!offsets || !zscores || (groupCount > 0 && !values)) {
+        std::cerr << "Error: Grubbs batch input params" << std::endl;
+        return -1;
+    }
+    for (size_t g = 0; g < groupCount; g++) {
+        if (offsets[g + 1] < offsets[g]) {
+            std::cerr << "Error: Grubbs batch offsets must be non-decreasing" << std::endl;
+            return -1;
+        }
+    }
+
+    ThreadPool& pool = globalThreadPool();
+    std::vector<GrubbsWorkspace> workspaces(pool.size());
+    // Slot 0 is the calling thread, which counts into its own stats directly
+    bool collectStats = grubbsStatsEnabled();
+    std::vector<GrubbsStats> workerStats(collectStats ? pool.size() : 0);
+
+    // Small groups are spread across threads; very large ones are left for
+    // afterwards so each of their passes can use the whole pool instead.
+    size_t grain = std::max<size_t>(1, groupCount / (pool.size() * 16));
+    pool.parallelFor(groupCount, grain, [&](size_t begin, size_t end, size_t slot) {
+        bool workerStatsOn = collectStats && slot != 0;
+        GrubbsStats before;
+        if (workerStatsOn) before = threadGrubbsStats();
+        for (size_t g = begin; g < end; g++) {
+            if (offsets[g + 1] - offsets[g] >= kParallelMinSize) continue;
+            runGroup(values, offsets, g, alpha, zscores, outlierMask, cleanMeans, cleanSds,
+                     groupOk, mode, workspaces[slot]);
+        }
+        if (workerStatsOn) addGrubbsStatsDelta(&workerStats[slot], threadGrubbsStats(), before);
+    });
+    for (const GrubbsStats& stats : workerStats) mergeGrubbsStats(stats);
+    for (size_t g = 0; g < groupCount; g++) {
+        if (offsets[g + 1] - offsets[g] < kParallelMinSize) continue;
+        runGroup(values, offsets, g, alpha, zscores, outlierMask, cleanMeans, cleanSds,
+                 groupOk, mode, workspaces[0]);
+    }
+    return 0;
+}
@@ -0,0 +1,18 @@
+#ifndef BATCHGRUBBS_H
+#define BATCHGRUBBS_H
+
+#include <cstddef>
+#include "mainFunctions.hpp"
+
+// Runs performGrubbs on every group values[offsets[g] .. offsets[g+1]) across
+// the global thread pool, with one reusable workspace per thread. zscores and
+// outlierMask (optional) are indexed like values; cleanMeans, cleanSds and
+// groupOk (all optional) like groups. Failed groups (e.g. zero standard
+// deviation) get groupOk = 0 and NaN outputs, without printing an error per
+// group. Returns -1 on invalid offsets.
+int performGrubbsBatch(const double* values, const size_t* offsets, size_t groupCount,
+                      double alpha, double* zscores, unsigned char* outlierMask,
+                      double* cleanMeans, double* cleanSds, unsigned char* groupOk,
+                      GrubbsMode mode = GRUBBS_MODE_AUTO);
+
+#endif // BATCHGRUBBS_H
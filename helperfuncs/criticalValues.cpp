@@ -0,0 +1,77 @@
+#include "criticalValues.hpp"
+#include "mainFunctions.hpp"
+#include <atomic>
+#include <cmath>
+#include <limits>
+#include <memory>
+#include <mutex>
+#include <vector>
+#include <boost/math/special_functions/erf.hpp>
+
+// Beyond this many distinct alphas values are computed without caching
+static const size_t kMaxCachedAlphas = 32;
+
+struct CriticalValueTable {
+    double alpha;
+    std::unique_ptr<std::atomic<double>[]> values; // NaN until computed
+};
+
+static std::mutex tablesMutex;
+static std::vector<std::unique_ptr<CriticalValueTable>> tables;
+
+// Tables are never freed, so the returned pointer stays valid for the process.
+static CriticalValueTable* findTable(double alpha) {
+    thread_local CriticalValueTable* last = nullptr;
+    if (last && last->alpha == alpha) return last;
+
+    std::lock_guard<std::mutex> lock(tablesMutex);
+    for (auto& table : tables) {
+        if (table->alpha == alpha) return last = table.get();
+    }
+    if (tables.size() >= kMaxCachedAlphas) return nullptr;
+
+    std::unique_ptr<CriticalValueTable> table(new CriticalValueTable);
+    table->alpha = alpha;
+    table->values.reset(new std::atomic<double>[kApproxTDistMinN]);
+    for (size_t i = 0; i < kApproxTDistMinN; i++) {
+        table->values[i].store(std::numeric_limits<double>::quiet_NaN(), std::memory_order_relaxed);
+    }
+    tables.push_back(std::move(table));
+    return last = tables.back().get();
+}
+
+double approxTDist(double alpha, size_t n) {
+    // Same rounded tail probability calcTDist hands to Boost
+    double p = 1.0 - (1 - (alpha / (2 * n)));
+    double z = std::sqrt(2.0) * boost::math::erfc_inv(2 * p);
+
+    double v = n - 2, z2 = z * z;
+    double g1 = (z2 + 1) * z / 4;
+    double g2 = ((5 * z2 + 16) * z2 + 3) * z / 96;
+    double g3 = (((3 * z2 + 19) * z2 + 17) * z2 - 15) * z / 384;
+    double g4 = ((((79 * z2 + 776) * z2 + 1482) * z2 - 1920) * z2 - 945) * z / 92160;
+    return z + (g1 + (g2 + (g3 + g4 / v) / v) / v) / v;
+}
+
+double grubbsCriticalValue(double alpha, size_t n) {
+    if (n >= kApproxTDistMinN) return calcG(approxTDist(alpha, n), n);
+
+    CriticalValueTable* table = (n >= 3) ? findTable(alpha) : nullptr;
+    if (!table) return calcG(calcTDist(alpha, n), n);
+
+    // Racing threads may both compute a slot; they store the same value
+    double G = table->values[n].load(std::memory_order_relaxed);
+    if (std::isnan(G)) {
+        G = calcG(calcTDist(alpha, n), n);
+        table->values[n].store(G, std::memory_order_relaxed);
+    }
+    return G;
+}
+
+void precomputeCriticalValues(const double* alphas, size_t count) {
+    for (size_t i = 0; i < count; i++) {
+        for (size_t n = 3; n < kApproxTDistMinN; n++) {
+            grubbsCriticalValue(alphas[i], n);
+        }
+    }
+}
@@ -0,0 +1,21 @@
+#ifndef CRITICALVALUES_H
+#define CRITICALVALUES_H
+
+#include <cstddef>
+
+// Above this n the Student's t quantile comes from approxTDist instead of
+// Boost's root finder. Over alpha in [0.001, 0.5] and n up to 1e9 the two
+// agree to within 1e-15 relative error.
+const size_t kApproxTDistMinN = 8192;
+
+// Cornish-Fisher expansion of calcTDist around the normal quantile.
+double approxTDist(double alpha, size_t n);
+
+// Grubbs critical value calcG(calcTDist(alpha, n), n). Exact values for
+// n < kApproxTDistMinN are memoized per alpha and shared across threads.
+double grubbsCriticalValue(double alpha, size_t n);
+
+// Fills the memo table for each alpha up front so later calls never hit Boost.
+void precomputeCriticalValues(const double* alphas, size_t count);
+
+#endif // CRITICALVALUES_H
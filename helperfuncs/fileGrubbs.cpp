@@ -0,0 +1,404 @@
+#include "fileGrubbs.hpp"
+#include "mainFunctions.hpp"
+#include "criticalValues.hpp"
+#include "grubbsStats.hpp"
+#include "simdKernels.hpp"
+#include "threadPool.hpp"
+#include <algorithm>
+#include <cmath>
+#include <cstring>
+#include <iostream>
+#include <vector>
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+// Chunk size of the file passes; fixed so results do not depend on the core count
+static const size_t kFileChunk = size_t(1) << 16;
+
+// Sizes fd to bytes with the disk space allocated up front. Writes through a
+// shared mapping of a sparse file raise SIGBUS when the disk fills up, instead
+// of failing in a way the caller could report.
+static bool preallocate(int fd, size_t bytes) {
+#if defined(__APPLE__)
+    fstore_t store = {F_ALLOCATECONTIG, F_PEOFPOSMODE, 0, (off_t)bytes, 0};
+    if (fcntl(fd, F_PREALLOCATE, &store) == -1) {
+        store.fst_flags = F_ALLOCATEALL;
+        if (fcntl(fd, F_PREALLOCATE, &store) == -1) return false;
+    }
+    return ftruncate(fd, (off_t)bytes) == 0;
+#else
+    return posix_fallocate(fd, 0, (off_t)bytes) == 0;
+#endif
+}
+
+// Whole-file mapping, unmapped and closed on destruction
+class MappedFile {
+public:
+    MappedFile() = default;
+    ~MappedFile() {
+        if (addr) munmap(addr, length);
+        if (fd >= 0) close(fd);
+    }
+    MappedFile(const MappedFile&) = delete;
+    MappedFile& operator=(const MappedFile&) = delete;
+
+    bool openRead(const char* path) {
+        fd = open(path, O_RDONLY);
+        if (fd < 0) return false;
+        struct stat st;
+        if (fstat(fd, &st) != 0) return false;
+        length = (size_t)st.st_size;
+        if (length == 0) return true;
+        addr = mmap(nullptr, length, PROT_READ, MAP_SHARED, fd, 0);
+        if (addr == MAP_FAILED) {
+            addr = nullptr;
+            return false;
+        }
+        madvise(addr, length, MADV_SEQUENTIAL);
+        return true;
+    }
+
+    // Creates path with all of its blocks reserved and maps it for writing. On
+    // failure the partly created file is removed again.
+    bool createWrite(const char* path, size_t bytes) {
+        fd = open(path, O_RDWR | O_CREAT | O_TRUNC, 0644);
+        if (fd < 0) return false;
+        length = bytes;
+        if (preallocate(fd, bytes)) {
+            addr = mmap(nullptr, length, PROT_READ | PROT_WRITE, MAP_SHARED, fd, 0);
+            if (addr != MAP_FAILED) return true;
+        }
+        addr = nullptr;
+        unlink(path);
+        return false;
+    }
+
+    // Same underlying file as path, so writing to path would clobber this mapping
+    bool sameFileAs(const char* path) const {
+        struct stat mine, other;
+        return fstat(fd, &mine) == 0 && stat(path, &other) == 0 &&
+               mine.st_dev == other.st_dev && mine.st_ino == other.st_ino;
+    }
+
+    unsigned char* data() const { return static_cast<unsigned char*>(addr); }
+    size_t bytes() const { return length; }
+
+private:
+    int fd = -1;
+    void* addr = nullptr;
+    size_t length = 0;
+};
+
+static inline bool pointLess(const SortedPoint& a, const SortedPoint& b) {
+    return a.value < b.value || (a.value == b.value && a.index < b.index);
+}
+
+// Removals always come off the ends of the sorted survivors, so the survivors
+// are exactly the points strictly between the last removed low point and the
+// last removed high point in (value, index) order. No per-point mask is kept.
+struct SurvivorBounds {
+    bool hasLow = false;
+    bool hasHigh = false;
+    SortedPoint low{0.0, 0};
+    SortedPoint high{0.0, 0};
+
+    bool contains(const SortedPoint& p) const {
+        return (!hasLow || pointLess(low, p)) && (!hasHigh || pointLess(p, high));
+    }
+};
+
+// Mean/M2 over the survivors, per fixed chunk with the blocked kernel and then
+// merged in chunk order. Chunks are filtered into per-thread scratch first.
+template <typename T>
+static void survivorMeanM2(const T* values, size_t size, const SurvivorBounds& bounds,
+                           size_t* count, double* mean, double* M2) {
+    ThreadPool& pool = globalThreadPool();
+    size_t chunks = (size + kFileChunk - 1) / kFileChunk;
+    std::vector<size_t> counts(chunks);
+    std::vector<double> means(chunks), M2s(chunks);
+    std::vector<std::vector<double>> scratch(pool.size());
+    recordGrubbsAllocation(chunks * (sizeof(size_t) + 2 * sizeof(double)));
+
+    pool.parallelFor(chunks, 1, [&](size_t begin, size_t end, size_t slot) {
+        std::vector<double>& buffer = scratch[slot];
+        if (buffer.empty()) {
+            buffer.resize(kFileChunk);
+            recordGrubbsAllocation(kFileChunk * sizeof(double));
+        }
+        for (size_t c = begin; c < end; c++) {
+            size_t start = c * kFileChunk, stop = std::min(start + kFileChunk, size);
+            size_t kept = 0;
+            for (size_t i = start; i < stop; i++) {
+                double x = values[i];
+                if (bounds.contains({x, i})) buffer[kept++] = x;
+            }
+            counts[c] = kept;
+            means[c] = M2s[c] = 0.0;
+            if (kept) kernelMeanM2(buffer.data(), kept, &means[c], &M2s[c]);
+        }
+    });
+
+    *count = 0;
+    *mean = *M2 = 0.0;
+    for (size_t c = 0; c < chunks; c++) {
+        if (counts[c]) mergeMeanM2(count, mean, M2, counts[c], means[c], M2s[c]);
+    }
+}
+
+// Per-thread bounded heaps for one candidate pass
+struct CandidateHeaps {
+    std::vector<SortedPoint> low;    // max-heap: largest of the smallest on top
+    std::vector<SortedPoint> high;   // min-heap: smallest of the largest on top
+};
+
+static bool greaterPoint(const SortedPoint& a, const SortedPoint& b) {
+    return pointLess(b, a);
+}
+
+static size_t heapCapacity(const std::vector<CandidateHeaps>& heaps) {
+    size_t total = 0;
+    for (const CandidateHeaps& heap : heaps) total += heap.low.capacity() + heap.high.capacity();
+    return total;
+}
+
+// Collects the lowCap smallest and highCap largest survivors, each sorted ascending
+template <typename T>
+static void collectCandidates(const T* values, size_t size, const SurvivorBounds& bounds,
+                              size_t lowCap, size_t highCap, std::vector<CandidateHeaps>& heaps,
+                              std::vector<SortedPoint>* low, std::vector<SortedPoint>* high) {
+    size_t chunks = (size + kFileChunk - 1) / kFileChunk;
+    size_t capacityBefore = heapCapacity(heaps) + low->capacity() + high->capacity();
+    for (CandidateHeaps& heap : heaps) {
+        heap.low.clear();
+        heap.high.clear();
+    }
+
+    globalThreadPool().parallelFor(chunks, 1, [&](size_t begin, size_t end, size_t slot) {
+        std::vector<SortedPoint>& lowHeap = heaps[slot].low;
+        std::vector<SortedPoint>& highHeap = heaps[slot].high;
+        for (size_t i = begin * kFileChunk; i < std::min(end * kFileChunk, size); i++) {
+            SortedPoint p{(double)values[i], i};
+            if (!bounds.contains(p)) continue;
+            if (lowHeap.size() < lowCap) {
+                lowHeap.push_back(p);
+                std::push_heap(lowHeap.begin(), lowHeap.end(), pointLess);
+            } else if (lowCap && pointLess(p, lowHeap.front())) {
+                std::pop_heap(lowHeap.begin(), lowHeap.end(), pointLess);
+                lowHeap.back() = p;
+                std::push_heap(lowHeap.begin(), lowHeap.end(), pointLess);
+            }
+            if (highHeap.size() < highCap) {
+                highHeap.push_back(p);
+                std::push_heap(highHeap.begin(), highHeap.end(), greaterPoint);
+            } else if (highCap && pointLess(highHeap.front(), p)) {
+                std::pop_heap(highHeap.begin(), highHeap.end(), greaterPoint);
+                highHeap.back() = p;
+                std::push_heap(highHeap.begin(), highHeap.end(), greaterPoint);
+            }
+        }
+    });
+
+    StatsTimer timer(&GrubbsStats::sortSeconds);
+    low->clear();
+    high->clear();
+    // Merge one thread at a time, trimming back to the cap so the merged sides
+    // never hold more than two threads' worth of candidates
+    for (const CandidateHeaps& heap : heaps) {
+        low->insert(low->end(), heap.low.begin(), heap.low.end());
+        high->insert(high->end(), heap.high.begin(), heap.high.end());
+        if (low->size() > lowCap) {
+            std::nth_element(low->begin(), low->begin() + lowCap, low->end(), pointLess);
+            low->resize(lowCap);
+        }
+        if (high->size() > highCap) {
+            std::nth_element(high->begin(), high->begin() + highCap, high->end(), greaterPoint);
+            high->resize(highCap);
+        }
+    }
+    std::sort(low->begin(), low->end(), pointLess);
+    std::sort(high->begin(), high->end(), pointLess);
+
+    size_t capacityAfter = heapCapacity(heaps) + low->capacity() + high->capacity();
+    recordGrubbsAllocation((capacityAfter - capacityBefore) * sizeof(SortedPoint));
+}
+
+template <typename T>
+static int runGrubbsFile(const T* values, size_t size, double alpha, size_t maxCandidates,
+                         const char* zscorePath, size_t* cleanSize, double* cleanMean,
+                         double* cleanSd) {
+    // Initial mean and M2 (unnormalized variance), the same pass as performGrubbs<T>
+    SurvivorBounds bounds;
+    size_t currentSize = size;
+    double meanValue, M2;
+    {
+        StatsTimer timer(&GrubbsStats::scanSeconds);
+        parallelMeanM2(values, size, &meanValue, &M2);
+    }
+    // With a NaN or infinity the stop test never passes and every pass over the
+    // file would remove maxCandidates points; fail before the first one
+    if (!std::isfinite(meanValue) || !std::isfinite(M2)) {
+        std::cerr << "Error: Grubbs file contains NaN or infinity" << std::endl;
+        return -1;
+    }
+
+    std::vector<CandidateHeaps> heaps(globalThreadPool().size());
+    std::vector<SortedPoint> low, high, ends;
+    size_t sortedTests = 0;
+    bool done = false;
+    while (!done && currentSize > 1) {
+        // Once every survivor fits in the candidate budget one pass finishes the test;
+        // otherwise the two sides are disjoint and may run out, which costs another pass.
+        bool complete = currentSize <= 2 * maxCandidates;
+        {
+            StatsTimer timer(&GrubbsStats::scanSeconds);
+            collectCandidates(values, size, bounds, complete ? currentSize : maxCandidates,
+                              complete ? 0 : maxCandidates, heaps, &low, &high);
+        }
+        size_t endsCapacity = ends.capacity();
+        ends.assign(low.begin(), low.end());
+        ends.insert(ends.end(), high.begin(), high.end());
+        recordGrubbsAllocation((ends.capacity() - endsCapacity) * sizeof(SortedPoint));
+        size_t split = complete ? 0 : low.size();   // first high candidate, 0 when complete
+
+        size_t lo = 0, hi = ends.size() - 1;
+        while (currentSize > 1) {
+            if (split && (lo == split || hi + 1 == split)) break;
+
+            double stdValue = std::sqrt(M2 / currentSize);
+            if (stdValue == 0.0) { done = true; break; }
+
+            double GFactor;
+            {
+                StatsTimer timer(&GrubbsStats::quantileSeconds);
+                GFactor = grubbsCriticalValue(alpha, currentSize);
+            }
+            sortedTests++;
+
+            const SortedPoint& lowPoint = ends[lo];
+            const SortedPoint& highPoint = ends[hi];
+            double rLow = std::fabs(lowPoint.value - meanValue);
+            double rHigh = std::fabs(highPoint.value - meanValue);
+            bool takeHigh = rHigh > rLow ||
+                (rHigh == rLow && preferOnTie(highPoint.value, highPoint.index,
+                                              lowPoint.value, lowPoint.index, meanValue));
+            double maxRes = takeHigh ? rHigh : rLow;
+
+            if (!(maxRes > GFactor)) { done = true; break; }
+
+            if (takeHigh) {
+                removeWelford(highPoint.value, currentSize, &meanValue, &M2);
+                bounds.high = highPoint;
+                bounds.hasHigh = true;
+                hi--;
+            } else {
+                removeWelford(lowPoint.value, currentSize, &meanValue, &M2);
+                bounds.low = lowPoint;
+                bounds.hasLow = true;
+                lo++;
+            }
+            currentSize--;
+        }
+        if (complete) done = true;
+    }
+    recordGrubbsIterations(0, sortedTests);
+
+    // Recompute mean/std over the clean set from scratch for numerical stability
+    double stdValue;
+    {
+        StatsTimer timer(&GrubbsStats::scanSeconds);
+        survivorMeanM2(values, size, bounds, &currentSize, &meanValue, &M2);
+        stdValue = (currentSize > 1) ? std::sqrt(M2 / currentSize) : 0.0;
+    }
+    if (stdValue == 0.0) {
+        std::cerr << "Error: Standard deviation is zero" << std::endl;
+        return -1;
+    }
+    if (cleanSize) *cleanSize = currentSize;
+    if (cleanMean) *cleanMean = meanValue;
+    if (cleanSd) *cleanSd = stdValue;
+
+    // Created only now, so a rejected input never leaves a zero-filled file behind
+    if (zscorePath) {
+        MappedFile output;
+        if (!output.createWrite(zscorePath, size * sizeof(double))) {
+            std::cerr << "Error: cannot create " << zscorePath << std::endl;
+            return -1;
+        }
+        parallelZScores(values, size, meanValue, stdValue,
+                        reinterpret_cast<double*>(output.data()));
+    }
+    return 0;
+}
+
+// Locates the value column inside the mapping and checks it is well formed
+static bool parseColumn(const MappedFile& file, GrubbsFileFormat format, size_t* offset,
+                        size_t* elementSize, size_t* count) {
+    if (format == GRUBBS_FILE_FLOAT64 || format == GRUBBS_FILE_FLOAT32) {
+        *offset = 0;
+        *elementSize = (format == GRUBBS_FILE_FLOAT64) ? sizeof(double) : sizeof(float);
+        if (file.bytes() % *elementSize != 0) {
+            std::cerr << "Error: Grubbs file size is not a multiple of the value size" << std::endl;
+            return false;
+        }
+        *count = file.bytes() / *elementSize;
+        return true;
+    }
+
+    GrubbsFileHeader header;
+    if (file.bytes() < sizeof(header)) {
+        std::cerr << "Error: Grubbs file is too short for its header" << std::endl;
+        return false;
+    }
+    std::memcpy(&header, file.data(), sizeof(header));
+    if (std::memcmp(header.magic, "GRBC", 4) != 0 || header.version != 1 ||
+        (header.elementSize != sizeof(double) && header.elementSize != sizeof(float)) ||
+        header.dataOffset < sizeof(header) || header.dataOffset % header.elementSize != 0 ||
+        header.dataOffset > file.bytes() ||
+        header.count > (file.bytes() - header.dataOffset) / header.elementSize) {
+        std::cerr << "Error: Grubbs file header is invalid" << std::endl;
+        return false;
+    }
+    *offset = header.dataOffset;
+    *elementSize = header.elementSize;
+    *count = header.count;
+    return true;
+}
+
+int performGrubbsFile(const char* inputPath, GrubbsFileFormat format, const char* zscorePath,
+                     double alpha, size_t* size, size_t* cleanSize, double* cleanMean,
+                     double* cleanSd, size_t maxCandidates) {
+    if (!inputPath || maxCandidates == 0) {
+        std::cerr << "Error: Grubbs file input params" << std::endl;
+        return -1;
+    }
+    recordGrubbsCall();
+    StatsTimer timer(&GrubbsStats::totalSeconds);
+
+    MappedFile input;
+    if (!input.openRead(inputPath)) {
+        std::cerr << "Error: cannot map " << inputPath << std::endl;
+        return -1;
+    }
+    size_t offset, elementSize, count;
+    if (!parseColumn(input, format, &offset, &elementSize, &count)) return -1;
+    if (size) *size = count;
+    if (count == 0) {
+        std::cerr << "Error: Grubbs input params" << std::endl;
+        return -1;
+    }
+
+    if (zscorePath && input.sameFileAs(zscorePath)) {
+        std::cerr << "Error: z-score file must differ from the input file" << std::endl;
+        return -1;
+    }
+
+    const unsigned char* column = input.data() + offset;
+    if (elementSize == sizeof(double)) {
+        return runGrubbsFile(reinterpret_cast<const double*>(column), count, alpha, maxCandidates,
+                             zscorePath, cleanSize, cleanMean, cleanSd);
+    }
+    return runGrubbsFile(reinterpret_cast<const float*>(column), count, alpha, maxCandidates,
+                         zscorePath, cleanSize, cleanMean, cleanSd);
+}
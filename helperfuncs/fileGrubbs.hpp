@@ -0,0 +1,42 @@
+#ifndef FILEGRUBBS_H
+#define FILEGRUBBS_H
+
+#include <cstddef>
+#include <cstdint>
+
+// Layouts accepted by performGrubbsFile. The raw formats are a bare column of
+// native-endian values; GRUBBS_FILE_HEADER starts with a GrubbsFileHeader.
+enum GrubbsFileFormat {
+    GRUBBS_FILE_FLOAT64,
+    GRUBBS_FILE_FLOAT32,
+    GRUBBS_FILE_HEADER
+};
+
+// 32-byte header followed by `count` values of `elementSize` bytes (8 for
+// float64, 4 for float32) starting at `dataOffset`, all native-endian.
+struct GrubbsFileHeader {
+    char magic[4];          // "GRBC"
+    uint32_t version;       // 1
+    uint32_t elementSize;
+    uint32_t reserved;
+    uint64_t count;
+    uint64_t dataOffset;    // >= 32 and a multiple of elementSize
+};
+
+// Default number of removal candidates kept per side of the distribution. Each
+// pass over the file can remove up to this many points from either side.
+const size_t kFileCandidates = size_t(1) << 18;
+
+// Grubbs test over a memory-mapped file, for inputs larger than RAM. Removes
+// the same points as performGrubbs, but never copies the input: the removal
+// loop only holds the maxCandidates smallest and largest survivors and rescans
+// the file when one side runs out. zscorePath (optional) receives size float64
+// z-scores in input order, written through a shared mapping; the file is only
+// created once the input has passed validation. Memory use is
+// O(maxCandidates * threads) regardless of the file size. Returns -1 on bad
+// input, unreadable files, NaN or infinite values, or zero spread.
+int performGrubbsFile(const char* inputPath, GrubbsFileFormat format, const char* zscorePath,
+                     double alpha, size_t* size, size_t* cleanSize, double* cleanMean,
+                     double* cleanSd, size_t maxCandidates = kFileCandidates);
+
+#endif // FILEGRUBBS_H
@@ -0,0 +1,15 @@
+#include "grubbsEngine.hpp"
+
+int GrubbsEngine::run(const double* values, size_t size, double* zscores, double alpha,
+                      unsigned char* outlierMask, double* cleanMean, double* cleanSd) {
+    std::lock_guard<std::mutex> lock(workspaceMutex);
+    return performGrubbs(values, size, zscores, alpha, outlierMask, cleanMean, cleanSd,
+                         engineMode, &workspace);
+}
+
+int GrubbsEngine::runInPlace(double* values, size_t size, double alpha, size_t* cleanSize,
+                             double* cleanMean, double* cleanSd, double* zscores) {
+    std::lock_guard<std::mutex> lock(workspaceMutex);
+    return performGrubbsInPlace(values, size, alpha, cleanSize, cleanMean, cleanSd, zscores,
+                                engineMode, &workspace);
+}
@@ -0,0 +1,41 @@
+#ifndef GRUBBSENGINE_H
+#define GRUBBSENGINE_H
+
+#include "mainFunctions.hpp"
+#include <cstddef>
+#include <mutex>
+
+// Reusable Grubbs runner: owns a GrubbsWorkspace sized to the largest input
+// seen so far, so repeated calls on similar sizes allocate nothing.
+// Calls on one engine are serialized by an internal mutex, so an engine can be
+// shared between threads safely; use one engine per thread to run in parallel.
+class GrubbsEngine {
+public:
+    explicit GrubbsEngine(GrubbsMode mode = GRUBBS_MODE_AUTO) : engineMode(mode) {}
+
+    // Pre-sizes the workspace so the first run does not allocate either
+    void reserve(size_t size) {
+        std::lock_guard<std::mutex> lock(workspaceMutex);
+        workspace.reserve(size);
+    }
+    size_t capacity() const {
+        std::lock_guard<std::mutex> lock(workspaceMutex);
+        return workspace.capacity();
+    }
+    GrubbsMode mode() const { return engineMode; }
+
+    // Same contract as performGrubbs / performGrubbsInPlace
+    int run(const double* values, size_t size, double* zscores, double alpha,
+            unsigned char* outlierMask = nullptr, double* cleanMean = nullptr,
+            double* cleanSd = nullptr);
+    int runInPlace(double* values, size_t size, double alpha, size_t* cleanSize,
+                   double* cleanMean = nullptr, double* cleanSd = nullptr,
+                   double* zscores = nullptr);
+
+private:
+    GrubbsMode engineMode;
+    GrubbsWorkspace workspace;
+    mutable std::mutex workspaceMutex;   // guards workspace
+};
+
+#endif // GRUBBSENGINE_H
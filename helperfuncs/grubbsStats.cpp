@@ -0,0 +1,67 @@
+#include "grubbsStats.hpp"
+#include <atomic>
+
+static std::atomic<bool> statsEnabled(false);
+
+static GrubbsStats& mutableStats() {
+    thread_local GrubbsStats stats;
+    return stats;
+}
+
+void setGrubbsStatsEnabled(bool enabled) {
+    statsEnabled.store(enabled, std::memory_order_relaxed);
+}
+
+bool grubbsStatsEnabled() {
+    return statsEnabled.load(std::memory_order_relaxed);
+}
+
+const GrubbsStats& threadGrubbsStats() {
+    return mutableStats();
+}
+
+void resetGrubbsStats() {
+    mutableStats() = GrubbsStats();
+}
+
+void addGrubbsStatsDelta(GrubbsStats* total, const GrubbsStats& after, const GrubbsStats& before) {
+    total->calls += after.calls - before.calls;
+    total->scanIterations += after.scanIterations - before.scanIterations;
+    total->sortedIterations += after.sortedIterations - before.sortedIterations;
+    total->bytesAllocated += after.bytesAllocated - before.bytesAllocated;
+    total->totalSeconds += after.totalSeconds - before.totalSeconds;
+    total->quantileSeconds += after.quantileSeconds - before.quantileSeconds;
+    total->scanSeconds += after.scanSeconds - before.scanSeconds;
+    total->sortSeconds += after.sortSeconds - before.sortSeconds;
+}
+
+void mergeGrubbsStats(const GrubbsStats& other) {
+    if (!grubbsStatsEnabled()) return;
+    addGrubbsStatsDelta(&mutableStats(), other, GrubbsStats());
+}
+
+void recordGrubbsCall() {
+    if (grubbsStatsEnabled()) mutableStats().calls++;
+}
+
+void recordGrubbsIterations(size_t scans, size_t sorted) {
+    if (!grubbsStatsEnabled()) return;
+    GrubbsStats& stats = mutableStats();
+    stats.scanIterations += scans;
+    stats.sortedIterations += sorted;
+}
+
+void recordGrubbsAllocation(size_t bytes) {
+    if (grubbsStatsEnabled()) mutableStats().bytesAllocated += bytes;
+}
+
+StatsTimer::StatsTimer(double GrubbsStats::* field) {
+    if (!grubbsStatsEnabled()) return;
+    target = &(mutableStats().*field);
+    start = std::chrono::steady_clock::now();
+}
+
+StatsTimer::~StatsTimer() {
+    if (!target) return;
+    *target += std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+}
@@ -0,0 +1,50 @@
+#ifndef GRUBBSSTATS_H
+#define GRUBBSSTATS_H
+
+#include <chrono>
+#include <cstddef>
+
+// Opt-in counters for the Grubbs hot path. Each thread accumulates into its
+// own GrubbsStats; nothing is measured while stats are disabled (the default).
+struct GrubbsStats {
+    size_t calls = 0;              // performGrubbs / performGrubbsInPlace / performNoOutlier
+    size_t scanIterations = 0;     // tests whose candidate came from a full residual scan
+    size_t sortedIterations = 0;   // tests whose candidate came from the sorted ends
+    size_t bytesAllocated = 0;     // heap bytes requested for scratch space and outputs
+    double totalSeconds = 0.0;
+    double quantileSeconds = 0.0;  // Grubbs critical values (t-distribution quantiles)
+    double scanSeconds = 0.0;      // max-residual scans
+    double sortSeconds = 0.0;      // sorting the survivors for the sorted engine
+};
+
+void setGrubbsStatsEnabled(bool enabled);
+bool grubbsStatsEnabled();
+
+// Counters of the calling thread since its last reset
+const GrubbsStats& threadGrubbsStats();
+void resetGrubbsStats();
+
+// *total += after - before, for collecting what a worker thread did during a job
+void addGrubbsStatsDelta(GrubbsStats* total, const GrubbsStats& after, const GrubbsStats& before);
+// Adds counters gathered on other threads to the calling thread's
+void mergeGrubbsStats(const GrubbsStats& other);
+
+void recordGrubbsCall();
+void recordGrubbsIterations(size_t scans, size_t sorted);
+void recordGrubbsAllocation(size_t bytes);
+
+// Adds the time until destruction to one of the calling thread's counters,
+// e.g. StatsTimer timer(&GrubbsStats::scanSeconds). No-op while disabled.
+class StatsTimer {
+public:
+    explicit StatsTimer(double GrubbsStats::* field);
+    ~StatsTimer();
+    StatsTimer(const StatsTimer&) = delete;
+    StatsTimer& operator=(const StatsTimer&) = delete;
+
+private:
+    double* target = nullptr;
+    std::chrono::steady_clock::time_point start;
+};
+
+#endif // GRUBBSSTATS_H
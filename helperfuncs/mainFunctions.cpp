@@ -1,31 +1,103 @@
 #include "mainFunctions.hpp"
+#include "criticalValues.hpp"
+#include "grubbsStats.hpp"
+#include "simdKernels.hpp"
+#include "threadPool.hpp"
 #include <iostream>
 #include <cstdio>
 #include <cstddef>
 #include <cstdlib>
 #include <cmath>
+#include <cstdint>
 #include <cstring>
-#include <memory>
+#include <algorithm>
+#include <new>
+#include <utility>
 #include <boost/math/distributions/students_t.hpp>
 
+static thread_local bool quietErrors = false;
+
+GrubbsQuietErrors::GrubbsQuietErrors() : previous(quietErrors) {
+    quietErrors = true;
+}
+
+GrubbsQuietErrors::~GrubbsQuietErrors() {
+    quietErrors = previous;
+}
+
+static void reportError(const char* message) {
+    if (!quietErrors) std::cerr << "Error: " << message << std::endl;
+}
+
+static const size_t kWorkspaceAlign = 64;
+
+static size_t alignUp(size_t bytes) {
+    return (bytes + kWorkspaceAlign - 1) & ~(kWorkspaceAlign - 1);
+}
+
+GrubbsWorkspace::~GrubbsWorkspace() {
+    if (block) ::operator delete(block, std::align_val_t(kWorkspaceAlign));
+}
+
+GrubbsWorkspace::GrubbsWorkspace(GrubbsWorkspace&& other) noexcept {
+    *this = std::move(other);
+}
+
+GrubbsWorkspace& GrubbsWorkspace::operator=(GrubbsWorkspace&& other) noexcept {
+    if (this != &other) {
+        if (block) ::operator delete(block, std::align_val_t(kWorkspaceAlign));
+        block = other.block;
+        cap = other.cap;
+        work = other.work;
+        index = other.index;
+        sorted = other.sorted;
+        mask = other.mask;
+        other.block = nullptr;
+        other.cap = 0;
+        other.work = nullptr;
+        other.index = nullptr;
+        other.sorted = nullptr;
+        other.mask = nullptr;
+    }
+    return *this;
+}
+
+void GrubbsWorkspace::reserve(size_t size) {
+    if (size <= cap) return;
+    // Grow geometrically so slowly increasing inputs settle quickly
+    size_t newCap = std::max(size, cap + cap / 2);
+
+    size_t workBytes = alignUp(newCap * sizeof(double));
+    size_t indexBytes = alignUp(newCap * sizeof(size_t));
+    size_t sortedBytes = alignUp(newCap * sizeof(SortedPoint));
+    size_t maskBytes = alignUp(newCap);
+    size_t totalBytes = workBytes + indexBytes + sortedBytes + maskBytes;
+    char* newBlock = static_cast<char*>(::operator new(totalBytes, std::align_val_t(kWorkspaceAlign)));
+    recordGrubbsAllocation(totalBytes);
+    if (block) ::operator delete(block, std::align_val_t(kWorkspaceAlign));
+
+    block = newBlock;
+    cap = newCap;
+    work = reinterpret_cast<double*>(newBlock);
+    index = reinterpret_cast<size_t*>(newBlock + workBytes);
+    sorted = reinterpret_cast<SortedPoint*>(newBlock + workBytes + indexBytes);
+    mask = reinterpret_cast<unsigned char*>(newBlock + workBytes + indexBytes + sortedBytes);
+}
+
 double calcZScore(double mean, double sd, double xUnit) {
     return (xUnit - mean)/sd;  
 }
 
-// Welford's algorithm
-double calcMeanStdDev(const double* arr, size_t size, double* meanResult) {
+// Blocked two-pass mean/M2 merged with Chan's update (see simdKernels)
+template <typename T>
+double calcMeanStdDev(const T* arr, size_t size, double* meanResult) {
     if (size == 0) {
         if (meanResult) *meanResult = 0.0;
         return 0.0;
     }
     
-    double mean = 0.0, M2 = 0.0;
-    for (size_t i = 0; i < size; i++) {
-        double d1 = arr[i] - mean;
-        mean += d1 / (i + 1);
-        double d2 = arr[i] - mean;
-        M2 += d1 * d2;
-    }
+    double mean, M2;
+    parallelMeanM2(arr, size, &mean, &M2);
     
     if (meanResult) *meanResult = mean;
     return (size > 1) ? std::sqrt(M2/size) : 0.0;
@@ -35,26 +107,19 @@ double calcG(double T, size_t n) {
     return ((n-1)/std::sqrt(n)) * ((T*T)/ (std::sqrt(n-2+(T*T))));
 }
 
-std::shared_ptr<double[]> calcResiduals(const double* values, double meanValue, size_t size) {
-    std::shared_ptr<double[]> residuals(new double[size]);    
+void calcResiduals(const double* values, double meanValue, size_t size, double* residuals) {
     for (size_t i = 0; i < size; i++) {
         residuals[i] = std::fabs(values[i] - meanValue);
     }
-
-    return residuals;
 }
 
 int maxResidual(const double* values, double meanValue, size_t size, double* maxRes, size_t* maxIndex) {    
     *maxRes = -1.0;
     *maxIndex = 0;
-    for (size_t i = 0; i < size; i++) {
-        double absResidual = std::fabs(values[i] - meanValue);
-        if (absResidual > *maxRes) {
-            *maxRes = absResidual;
-            *maxIndex = i;
-        }
-    }
-    
+    if (size == 0) return 0;
+
+    bool tied;
+    *maxIndex = parallelArgmaxResidual(values, size, meanValue, maxRes, &tied);
     return 0;
 }
 
@@ -63,87 +128,332 @@ double calcTDist(double alpha, size_t n) {
     return boost::math::quantile(dist, (1-(alpha/(2*n))));
 }
 
-int performGrubbs(std::shared_ptr<double[]>& values, size_t size, std::shared_ptr<double[]>& finalValues,
-                 size_t* finalSize, std::shared_ptr<double[]>& zscores, double alpha) {
-    if (size == 0 || !values || !finalSize || !zscores) {
-        std::cerr << "Error: Grubbs input params" << std::endl;
-        return -1;
+void addWelford(double x, size_t n, double* mean, double* M2) {
+    double d1 = x - *mean;
+    *mean += d1 / (n + 1);
+    *M2   += d1 * (x - *mean);
+}
+
+// Reverse Welford: drop x from a set of n values with the given mean and M2
+void removeWelford(double x, size_t n, double* mean, double* M2) {
+    double prevMean = *mean;
+    *mean  = (n * prevMean - x) / (n - 1);
+    *M2   -= (x - prevMean) * (x - *mean);
+    if (*M2 < 0.0) *M2 = 0.0;  // guard floating-point drift
+}
+
+// Tie-break between two candidates with equal |x - mean|, so that the scan and
+// the sorted engine always remove the same point: points above the mean win,
+// then the more extreme value, then the index the sorted order would reach first.
+bool preferOnTie(double v, size_t idx, double bestV, size_t bestIdx, double mean) {
+    bool above = v > mean;
+    if (above != (bestV > mean)) return above;
+    if (v != bestV) return above ? v > bestV : v < bestV;
+    return above ? idx > bestIdx : idx < bestIdx;
+}
+
+// Below this size AUTO never leaves the scan; the sort does not pay for itself.
+static const size_t kSortedMinSize = 64;
+
+// One-sided tests put all of alpha in one tail: quantile 1 - alpha/n instead
+// of 1 - alpha/(2n), which is calcTDist at 2 * alpha.
+template <GrubbsTail tail>
+static double tailCriticalValue(double alpha, size_t n) {
+    return grubbsCriticalValue(tail == GRUBBS_TWO_SIDED ? alpha : 2 * alpha, n);
+}
+
+// Next removal candidate among n values: the largest |x - mean| for two-sided
+// tests, else the largest (UPPER) or smallest (LOWER) value, with the sorted
+// engine's tie rule. index maps positions to input order (nullptr: identity).
+template <GrubbsTail tail, typename V>
+static size_t findCandidate(const V* values, const size_t* index, size_t n, double mean,
+                            double* maxRes) {
+    auto indexAt = [index](size_t i) { return index ? index[i] : i; };
+    if (tail == GRUBBS_TWO_SIDED) {
+        bool tied;
+        size_t maxIndex = parallelArgmaxResidual(values, n, mean, maxRes, &tied);
+        if (tied) {
+            for (size_t i = maxIndex + 1; i < n; i++) {
+                if (std::fabs(values[i] - mean) == *maxRes &&
+                    preferOnTie(values[i], indexAt(i), values[maxIndex], indexAt(maxIndex), mean)) {
+                    maxIndex = i;
+                }
+            }
+        }
+        return maxIndex;
+    }
+
+    size_t best = 0;
+    for (size_t i = 1; i < n; i++) {
+        double v = values[i], bestV = values[best];
+        bool better = (tail == GRUBBS_UPPER)
+            ? (v > bestV || (v == bestV && indexAt(i) > indexAt(best)))
+            : (v < bestV || (v == bestV && indexAt(i) < indexAt(best)));
+        if (better) best = i;
     }
+    double bestV = values[best];
+    *maxRes = (tail == GRUBBS_UPPER) ? bestV - mean : mean - bestV;
+    return best;
+}
 
-    std::shared_ptr<double[]> currentValues(new double[size]);
-    std::copy(values.get(), values.get() + size, currentValues.get());
+// Iterative removal loop shared by performGrubbs and performGrubbsInPlace.
+// Marks removed points in outlierMask (size bytes) and sets *cleanSize to the
+// number of survivors. When anything was removed the survivors are left in
+// input order at the front of workspace.work; otherwise values itself is the
+// clean set and the input is never copied. The workspace must already hold
+// size points. Returns -1 if the input holds NaN or infinity.
+template <typename T, GrubbsTail tail>
+static int removeOutliers(const T* values, size_t size, double alpha, GrubbsMode mode,
+                          unsigned char* outlierMask, GrubbsWorkspace& workspace,
+                          size_t* cleanSize) {
+    double* currentValues = workspace.work;
+    size_t* currentIndex = workspace.index;
     size_t currentSize = size;
+    bool copied = false;
+
+    // Initial mean and M2 (unnormalized variance), straight from the input
+    double meanValue, M2;
+    parallelMeanM2(values, size, &meanValue, &M2);
 
-    // Initial mean and M2 (unnormalized variance) via Welford's
-    double meanValue = 0.0, M2 = 0.0;
-    for (size_t i = 0; i < currentSize; i++) {
-        double d1 = currentValues[i] - meanValue;
-        meanValue += d1 / (i + 1);
-        M2 += d1 * (currentValues[i] - meanValue);
+    // A NaN or infinity would never pass the stop test, and NaN keys would
+    // break the sort's ordering; no mode can give a meaningful answer
+    if (!std::isfinite(meanValue) || !std::isfinite(M2)) {
+        reportError("Grubbs input contains NaN or infinity");
+        return -1;
     }
 
-    while (currentSize > 1) {
-        double stdValue = (currentSize > 1) ? std::sqrt(M2 / currentSize) : 0.0;
-        if (stdValue == 0.0) break;
+    // Each scan costs O(n); once about log2(n) of them have run, sorting the
+    // survivors is cheaper than betting on the loop stopping soon.
+    size_t scanBudget = 0;
+    if (mode == GRUBBS_MODE_SCAN || (mode == GRUBBS_MODE_AUTO && size < kSortedMinSize)) {
+        scanBudget = size;
+    } else if (mode == GRUBBS_MODE_AUTO) {
+        while ((size_t(1) << scanBudget) < size) scanBudget++;
+    }
 
-        double T = calcTDist(alpha, currentSize);
-        double GFactor = calcG(T, currentSize);
+    bool done = false;
+    size_t scanTests = 0, sortedTests = 0;
+    while (currentSize > 1 && scanBudget > 0) {
+        double stdValue = std::sqrt(M2 / currentSize);
+        if (stdValue == 0.0) { done = true; break; }
 
-        // Single pass: find max absolute deviation
-        double maxRes = -1.0;
-        size_t maxIndex = 0;
-        for (size_t i = 0; i < currentSize; i++) {
-            double r = std::fabs(currentValues[i] - meanValue);
-            if (r > maxRes) { maxRes = r; maxIndex = i; }
+        double GFactor;
+        {
+            StatsTimer timer(&GrubbsStats::quantileSeconds);
+            GFactor = tailCriticalValue<tail>(alpha, currentSize);
         }
 
-        if (maxRes <= GFactor) break;
+        // Single vectorized pass: the first one reads the input in place
+        StatsTimer scanTimer(&GrubbsStats::scanSeconds);
+        scanTests++;
+        double maxRes;
+        size_t maxIndex = copied
+            ? findCandidate<tail>(currentValues, currentIndex, currentSize, meanValue, &maxRes)
+            : findCandidate<tail>(values, nullptr, currentSize, meanValue, &maxRes);
+
+        if (!(maxRes > GFactor)) { done = true; break; }
+
+        // Only data with outliers pays for the working copy
+        if (!copied) {
+            std::copy(values, values + size, currentValues);
+            for (size_t i = 0; i < size; i++) currentIndex[i] = i;
+            copied = true;
+        }
 
         // Reverse Welford to prevent full scan
-        double removed   = currentValues[maxIndex];
-        double prevMean  = meanValue;
-        meanValue        = (currentSize * meanValue - removed) / (currentSize - 1);
-        M2              -= (removed - prevMean) * (removed - meanValue);
-        if (M2 < 0.0) M2 = 0.0;  // guard floating-point drift
-        
+        removeWelford(currentValues[maxIndex], currentSize, &meanValue, &M2);
+
         currentValues[maxIndex] = currentValues[currentSize - 1]; // O(1) removal
+        std::swap(currentIndex[maxIndex], currentIndex[currentSize - 1]);
         currentSize--;
+        scanBudget--;
     }
 
-    // Copy clean set and recompute mean/std from scratch for numerical stability
-    std::shared_ptr<double[]> newFinalValues(new double[currentSize]);
-    finalValues = newFinalValues;
-    std::copy(currentValues.get(), currentValues.get() + currentSize, finalValues.get());
-    *finalSize = currentSize;
+    std::memset(outlierMask, 0, size);
+    for (size_t i = currentSize; i < size; i++) outlierMask[currentIndex[i]] = 1;
 
-    double stdValue = calcMeanStdDev(finalValues.get(), currentSize, &meanValue);
-    if (stdValue == 0.0) {
-        std::cerr << "Error: Standard deviation is zero" << std::endl;
+    if (!done && currentSize > 1) {
+        // Sorted engine: the point farthest from the mean is always at one end of
+        // the sorted survivors, so each removal is O(1) after the initial sort.
+        SortedPoint* sorted = workspace.sorted;
+        {
+            StatsTimer timer(&GrubbsStats::sortSeconds);
+            if (copied) {
+                for (size_t i = 0; i < currentSize; i++) sorted[i] = {currentValues[i], currentIndex[i]};
+            } else {
+                for (size_t i = 0; i < currentSize; i++) sorted[i] = {(double)values[i], i};
+            }
+            std::sort(sorted, sorted + currentSize,
+                      [](const SortedPoint& a, const SortedPoint& b) {
+                          return a.value < b.value || (a.value == b.value && a.index < b.index);
+                      });
+        }
+
+        size_t lo = 0, hi = currentSize - 1;
+        while (currentSize > 1) {
+            double stdValue = std::sqrt(M2 / currentSize);
+            if (stdValue == 0.0) break;
+
+            double GFactor;
+            {
+                StatsTimer timer(&GrubbsStats::quantileSeconds);
+                GFactor = tailCriticalValue<tail>(alpha, currentSize);
+            }
+            sortedTests++;
+
+            const SortedPoint& low = sorted[lo];
+            const SortedPoint& high = sorted[hi];
+            double rLow = std::fabs(low.value - meanValue);
+            double rHigh = std::fabs(high.value - meanValue);
+            bool takeHigh;
+            double maxRes;
+            if (tail == GRUBBS_TWO_SIDED) {
+                takeHigh = rHigh > rLow ||
+                    (rHigh == rLow && preferOnTie(high.value, high.index, low.value, low.index, meanValue));
+                maxRes = takeHigh ? rHigh : rLow;
+            } else {
+                takeHigh = (tail == GRUBBS_UPPER);
+                maxRes = takeHigh ? high.value - meanValue : meanValue - low.value;
+            }
+
+            if (!(maxRes > GFactor)) break;
+
+            const SortedPoint& removed = takeHigh ? high : low;
+            removeWelford(removed.value, currentSize, &meanValue, &M2);
+            outlierMask[removed.index] = 1;
+            if (takeHigh) hi--; else lo++;
+            currentSize--;
+        }
+    }
+    recordGrubbsIterations(scanTests, sortedTests);
+
+    // Compact survivors in input order so the final statistics do not depend on the mode
+    if (currentSize < size) {
+        for (size_t i = 0, j = 0; i < size; i++) {
+            if (!outlierMask[i]) currentValues[j++] = values[i];
+        }
+    }
+    *cleanSize = currentSize;
+    return 0;
+}
+
+template <typename T, GrubbsTail tail, bool emitZScores>
+int performGrubbs(const T* values, size_t size, double* zscores, double alpha,
+                 unsigned char* outlierMask, double* cleanMean, double* cleanSd,
+                 GrubbsMode mode, GrubbsWorkspace* workspace) {
+    if (size == 0 || !values || (emitZScores && !zscores)) {
+        reportError("Grubbs input params");
         return -1;
     }
+    recordGrubbsCall();
+    StatsTimer timer(&GrubbsStats::totalSeconds);
 
-    for (size_t i = 0; i < size; i++) {
-        zscores[i] = calcZScore(meanValue, stdValue, values[i]);
+    GrubbsWorkspace localWorkspace;
+    if (!workspace) workspace = &localWorkspace;
+    workspace->reserve(size);
+    if (!outlierMask) outlierMask = workspace->mask;
+    size_t currentSize;
+    if (removeOutliers<T, tail>(values, size, alpha, mode, outlierMask, *workspace, &currentSize) != 0) {
+        return -1;
+    }
+
+    // Recompute mean/std over the clean set from scratch for numerical stability
+    double meanValue;
+    double stdValue = (currentSize == size) ? calcMeanStdDev(values, size, &meanValue)
+                                            : calcMeanStdDev(workspace->work, currentSize, &meanValue);
+    if (stdValue == 0.0) {
+        reportError("Standard deviation is zero");
+        return -1;
     }
+    if (cleanMean) *cleanMean = meanValue;
+    if (cleanSd) *cleanSd = stdValue;
+
+    if (emitZScores) parallelZScores(values, size, meanValue, stdValue, zscores);
     return 0;
 }
 
-int performNoOutlier(std::shared_ptr<double[]>& values, size_t size,std::shared_ptr<double[]>& zscores) {
-    if (size == 0 || !values || !zscores) {
-        std::cerr << "Error: NoOutlier input params" << std::endl;
+int performGrubbsInPlace(double* values, size_t size, double alpha, size_t* cleanSize,
+                        double* cleanMean, double* cleanSd, double* zscores,
+                        GrubbsMode mode, GrubbsWorkspace* workspace) {
+    if (size == 0 || !values || !cleanSize) {
+        reportError("Grubbs input params");
+        return -1;
+    }
+    recordGrubbsCall();
+    StatsTimer timer(&GrubbsStats::totalSeconds);
+
+    GrubbsWorkspace localWorkspace;
+    if (!workspace) workspace = &localWorkspace;
+    workspace->reserve(size);
+    size_t currentSize;
+    if (removeOutliers<double, GRUBBS_TWO_SIDED>(values, size, alpha, mode, workspace->mask,
+                                                 *workspace, &currentSize) != 0) {
         return -1;
     }
+
+    // Survivors already sit at the front of work; append the outliers, then copy back
+    if (currentSize < size) {
+        double* work = workspace->work;
+        for (size_t i = 0, j = currentSize; i < size; i++) {
+            if (workspace->mask[i]) work[j++] = values[i];
+        }
+        std::copy(work, work + size, values);
+    }
+    *cleanSize = currentSize;
+
     double meanValue;
-    double stdValue = calcMeanStdDev(values.get(), size, &meanValue);
-    
+    double stdValue = calcMeanStdDev(values, currentSize, &meanValue);
     if (stdValue == 0.0) {
-        std::cerr << "Error: Standard deviation is zero" << std::endl;
+        reportError("Standard deviation is zero");
         return -1;
     }
+    if (cleanMean) *cleanMean = meanValue;
+    if (cleanSd) *cleanSd = stdValue;
+
+    if (zscores) parallelZScores(values, size, meanValue, stdValue, zscores);
+    return 0;
+}
+
+template <typename T, bool emitZScores>
+int performNoOutlier(const T* values, size_t size, double* zscores,
+                    double* meanResult, double* sdResult) {
+    if (size == 0 || !values || (emitZScores && !zscores)) {
+        reportError("NoOutlier input params");
+        return -1;
+    }
+    recordGrubbsCall();
+    StatsTimer timer(&GrubbsStats::totalSeconds);
+
+    double meanValue;
+    double stdValue = calcMeanStdDev(values, size, &meanValue);
     
-    for (size_t i = 0; i < size; i++) {
-        zscores[i] = calcZScore(meanValue, stdValue, values[i]);
+    if (stdValue == 0.0) {
+        reportError("Standard deviation is zero");
+        return -1;
     }
+    if (meanResult) *meanResult = meanValue;
+    if (sdResult) *sdResult = stdValue;
     
+    if (emitZScores) parallelZScores(values, size, meanValue, stdValue, zscores);
     return 0;
 }
+
+// Explicit instantiations: every input type with every tail, with and without z-scores
+#define GRUBBS_INSTANTIATE_TAIL(T, tail)                                                      \
+    template int performGrubbs<T, tail, true>(const T*, size_t, double*, double,             \
+        unsigned char*, double*, double*, GrubbsMode, GrubbsWorkspace*);                     \
+    template int performGrubbs<T, tail, false>(const T*, size_t, double*, double,            \
+        unsigned char*, double*, double*, GrubbsMode, GrubbsWorkspace*);
+
+#define GRUBBS_INSTANTIATE_TYPE(T)                                                            \
+    template double calcMeanStdDev<T>(const T*, size_t, double*);                             \
+    template int performNoOutlier<T, true>(const T*, size_t, double*, double*, double*);      \
+    template int performNoOutlier<T, false>(const T*, size_t, double*, double*, double*);     \
+    GRUBBS_INSTANTIATE_TAIL(T, GRUBBS_TWO_SIDED)                                              \
+    GRUBBS_INSTANTIATE_TAIL(T, GRUBBS_UPPER)                                                  \
+    GRUBBS_INSTANTIATE_TAIL(T, GRUBBS_LOWER)
+
+GRUBBS_INSTANTIATE_TYPE(double)
+GRUBBS_INSTANTIATE_TYPE(float)
+GRUBBS_INSTANTIATE_TYPE(int32_t)
+GRUBBS_INSTANTIATE_TYPE(int64_t)
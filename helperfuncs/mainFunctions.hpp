@@ -2,17 +2,103 @@
 #define MAINFUNCTIONS_H
 
 #include <cstddef>
-#include <memory>
+
+// Outlier-removal strategy used by performGrubbs. All modes remove the same
+// points; they only differ in how the next candidate is found.
+enum GrubbsMode {
+    GRUBBS_MODE_AUTO,    // scan first, switch to sorted once removals pile up
+    GRUBBS_MODE_SCAN,    // O(n) max-residual scan per removed outlier
+    GRUBBS_MODE_SORTED   // sort once, then remove from either end in O(1)
+};
+
+// Which side(s) of the distribution the test examines. One-sided tests only
+// look at the largest (UPPER) or smallest (LOWER) value and use the t quantile
+// at 1 - alpha/n instead of 1 - alpha/(2n).
+enum GrubbsTail {
+    GRUBBS_TWO_SIDED,
+    GRUBBS_UPPER,
+    GRUBBS_LOWER
+};
+
+// Survivor value and its input position, for the sorted removal engine
+struct SortedPoint {
+    double value;
+    size_t index;
+};
+
+// Scratch for performGrubbs: one 64-byte aligned block split into the
+// per-point arrays below. It grows to the largest input seen and is then
+// reused, so steady-state calls do not touch the heap.
+class GrubbsWorkspace {
+public:
+    GrubbsWorkspace() = default;
+    ~GrubbsWorkspace();
+    GrubbsWorkspace(GrubbsWorkspace&& other) noexcept;
+    GrubbsWorkspace& operator=(GrubbsWorkspace&& other) noexcept;
+    GrubbsWorkspace(const GrubbsWorkspace&) = delete;
+    GrubbsWorkspace& operator=(const GrubbsWorkspace&) = delete;
+
+    // Makes room for size points; existing contents are not kept
+    void reserve(size_t size);
+    size_t capacity() const { return cap; }
+
+    double* work = nullptr;
+    size_t* index = nullptr;
+    SortedPoint* sorted = nullptr;
+    unsigned char* mask = nullptr;
+
+private:
+    void* block = nullptr;
+    size_t cap = 0;
+};
+
+// Silences the calling thread's "Error: ..." messages from the functions below
+// until destruction, for callers that report failures through their own
+// outputs. Return values are unchanged.
+class GrubbsQuietErrors {
+public:
+    GrubbsQuietErrors();
+    ~GrubbsQuietErrors();
+    GrubbsQuietErrors(const GrubbsQuietErrors&) = delete;
+    GrubbsQuietErrors& operator=(const GrubbsQuietErrors&) = delete;
+
+private:
+    bool previous;
+};
 
 double calcZScore(double xbar, double sd, double xUnit);
-double calcMeanStdDev(const double* arr, size_t size, double* meanResult);
+// Templates taking input values are instantiated for double, float, int32_t
+// and int64_t. Input is read in place and accumulated in double.
+template <typename T>
+double calcMeanStdDev(const T* arr, size_t size, double* meanResult);
 double calcG(double T, size_t n);
-std::shared_ptr<double[]> calcResiduals(const double* values, double meanValue, size_t size);
+void calcResiduals(const double* values, double meanValue, size_t size, double* residuals);
 int maxResidual(const double* values, double meanValue, size_t size, 
                double* maxRes, size_t* maxIndex);
 double calcTDist(double alpha, size_t n);
-int performGrubbs(std::shared_ptr<double[]>& values, size_t size, std::shared_ptr<double[]>& finalValues, 
-                 size_t* finalSize, std::shared_ptr<double[]>& zscores, double alpha);
-int performNoOutlier(std::shared_ptr<double[]>& values, size_t size, std::shared_ptr<double[]>& zscores);
 
-#endif // MAINFUNCTIONS_H
\ No newline at end of file
+// Welford updates for adding / removing x to / from a set of n values (n counts
+// the set before the update), and the tie-break the removal engines share.
+void addWelford(double x, size_t n, double* mean, double* M2);
+void removeWelford(double x, size_t n, double* mean, double* M2);
+bool preferOnTie(double v, size_t idx, double bestV, size_t bestIdx, double mean);
+
+// zscores must hold size doubles unless emitZScores is false; outlierMask (size
+// bytes), cleanMean and cleanSd are optional outputs. workspace (optional) is
+// reused instead of allocating per call. Clean input is never copied. Returns
+// -1 on bad params, NaN or infinite values, or zero spread.
+template <typename T, GrubbsTail tail = GRUBBS_TWO_SIDED, bool emitZScores = true>
+int performGrubbs(const T* values, size_t size, double* zscores, double alpha,
+                 unsigned char* outlierMask, double* cleanMean, double* cleanSd,
+                 GrubbsMode mode = GRUBBS_MODE_AUTO, GrubbsWorkspace* workspace = nullptr);
+// In-place variant: reorders values so the *cleanSize survivors come first and
+// the outliers form the tail, each part in input order. zscores (optional)
+// follows the reordered buffer.
+int performGrubbsInPlace(double* values, size_t size, double alpha, size_t* cleanSize,
+                        double* cleanMean, double* cleanSd, double* zscores,
+                        GrubbsMode mode = GRUBBS_MODE_AUTO, GrubbsWorkspace* workspace = nullptr);
+template <typename T, bool emitZScores = true>
+int performNoOutlier(const T* values, size_t size, double* zscores,
+                    double* meanResult, double* sdResult);
+
+#endif // MAINFUNCTIONS_H
@@ -0,0 +1,382 @@
+#include "simdKernels.hpp"
+#include <algorithm>
+#include <atomic>
+#include <cmath>
+#include <cstdint>
+
+#if (defined(__x86_64__) || defined(__i386__)) && (defined(__GNUC__) || defined(__clang__))
+#define GRUBBS_X86_DISPATCH 1
+#include <immintrin.h>
+#endif
+
+// Elements per block; small enough that the second pass over a block hits L1
+static const size_t kBlockSize = 512;
+
+void mergeMeanM2(size_t* n, double* mean, double* M2, size_t nb, double mb, double M2b) {
+    size_t na = *n;
+    size_t total = na + nb;
+    double delta = mb - *mean;
+    *mean += delta * nb / total;
+    *M2   += M2b + delta * delta * ((double)na * nb / total);
+    *n = total;
+}
+
+// Finds the first index reaching best inside the winning block and flags ties
+template <typename T>
+static size_t resolveBlock(const T* values, size_t size, double mean, double best,
+                           size_t blockStart, bool crossTie, double* maxRes, bool* tied) {
+    size_t blockEnd = std::min(blockStart + kBlockSize, size);
+    size_t maxIndex = blockStart;
+    size_t hits = 0;
+    for (size_t i = blockStart; i < blockEnd; i++) {
+        if (std::fabs(values[i] - mean) == best) {
+            if (hits == 0) maxIndex = i;
+            hits++;
+        }
+    }
+    *maxRes = best;
+    *tied = crossTie || hits > 1;
+    return maxIndex;
+}
+
+// ---- scalar ----
+
+template <typename T>
+static void meanM2Scalar(const T* arr, size_t size, double* mean, double* M2) {
+    size_t n = 0;
+    *mean = 0.0;
+    *M2 = 0.0;
+    for (size_t start = 0; start < size; start += kBlockSize) {
+        size_t end = std::min(start + kBlockSize, size);
+        size_t nb = end - start;
+
+        double sum = 0.0;
+        for (size_t i = start; i < end; i++) sum += arr[i];
+        double mb = sum / nb;
+
+        double M2b = 0.0;
+        for (size_t i = start; i < end; i++) {
+            double d = arr[i] - mb;
+            M2b += d * d;
+        }
+        mergeMeanM2(&n, mean, M2, nb, mb, M2b);
+    }
+}
+
+template <typename T>
+static size_t argmaxResidualScalar(const T* values, size_t size, double mean,
+                                   double* maxRes, bool* tied) {
+    double best = -1.0;
+    size_t bestBlock = 0;
+    bool crossTie = false;
+    for (size_t start = 0; start < size; start += kBlockSize) {
+        size_t end = std::min(start + kBlockSize, size);
+        double blockMax = -1.0;
+        for (size_t i = start; i < end; i++) blockMax = std::max(blockMax, std::fabs(values[i] - mean));
+
+        if (blockMax > best) { best = blockMax; bestBlock = start; crossTie = false; }
+        else if (blockMax == best) crossTie = true;
+    }
+    return resolveBlock(values, size, mean, best, bestBlock, crossTie, maxRes, tied);
+}
+
+template <typename T>
+static void zscoresScalar(const T* values, size_t size, double mean, double sd, double* zscores) {
+    double invSd = 1.0 / sd;
+    for (size_t i = 0; i < size; i++) zscores[i] = (values[i] - mean) * invSd;
+}
+
+#ifdef GRUBBS_X86_DISPATCH
+
+// ---- AVX2 ----
+
+// Loads 4 values widened to double; float32 and int32 convert in one
+// instruction, int64 has no AVX2 conversion and goes through scalar lanes.
+__attribute__((target("avx2")))
+static inline __m256d loadAvx2(const double* p) {
+    return _mm256_loadu_pd(p);
+}
+
+__attribute__((target("avx2")))
+static inline __m256d loadAvx2(const float* p) {
+    return _mm256_cvtps_pd(_mm_loadu_ps(p));
+}
+
+__attribute__((target("avx2")))
+static inline __m256d loadAvx2(const int32_t* p) {
+    return _mm256_cvtepi32_pd(_mm_loadu_si128(reinterpret_cast<const __m128i*>(p)));
+}
+
+__attribute__((target("avx2")))
+static inline __m256d loadAvx2(const int64_t* p) {
+    return _mm256_set_pd((double)p[3], (double)p[2], (double)p[1], (double)p[0]);
+}
+
+__attribute__((target("avx2")))
+static inline double hsumAvx2(__m256d v) {
+    __m128d lo = _mm256_castpd256_pd128(v);
+    __m128d hi = _mm256_extractf128_pd(v, 1);
+    lo = _mm_add_pd(lo, hi);
+    return _mm_cvtsd_f64(_mm_add_sd(lo, _mm_unpackhi_pd(lo, lo)));
+}
+
+__attribute__((target("avx2")))
+static inline double hmaxAvx2(__m256d v) {
+    __m128d lo = _mm256_castpd256_pd128(v);
+    __m128d hi = _mm256_extractf128_pd(v, 1);
+    lo = _mm_max_pd(lo, hi);
+    return _mm_cvtsd_f64(_mm_max_sd(lo, _mm_unpackhi_pd(lo, lo)));
+}
+
+template <typename T>
+__attribute__((target("avx2")))
+static void meanM2Avx2(const T* arr, size_t size, double* mean, double* M2) {
+    size_t n = 0;
+    *mean = 0.0;
+    *M2 = 0.0;
+    for (size_t start = 0; start < size; start += kBlockSize) {
+        size_t end = std::min(start + kBlockSize, size);
+        size_t nb = end - start;
+
+        __m256d s0 = _mm256_setzero_pd(), s1 = _mm256_setzero_pd();
+        size_t i = start;
+        for (; i + 8 <= end; i += 8) {
+            s0 = _mm256_add_pd(s0, loadAvx2(arr + i));
+            s1 = _mm256_add_pd(s1, loadAvx2(arr + i + 4));
+        }
+        double sum = hsumAvx2(_mm256_add_pd(s0, s1));
+        for (; i < end; i++) sum += arr[i];
+        double mb = sum / nb;
+
+        __m256d m = _mm256_set1_pd(mb);
+        __m256d q0 = _mm256_setzero_pd(), q1 = _mm256_setzero_pd();
+        i = start;
+        for (; i + 8 <= end; i += 8) {
+            __m256d d0 = _mm256_sub_pd(loadAvx2(arr + i), m);
+            __m256d d1 = _mm256_sub_pd(loadAvx2(arr + i + 4), m);
+            q0 = _mm256_add_pd(q0, _mm256_mul_pd(d0, d0));
+            q1 = _mm256_add_pd(q1, _mm256_mul_pd(d1, d1));
+        }
+        double M2b = hsumAvx2(_mm256_add_pd(q0, q1));
+        for (; i < end; i++) {
+            double d = arr[i] - mb;
+            M2b += d * d;
+        }
+        mergeMeanM2(&n, mean, M2, nb, mb, M2b);
+    }
+}
+
+template <typename T>
+__attribute__((target("avx2")))
+static size_t argmaxResidualAvx2(const T* values, size_t size, double mean,
+                                 double* maxRes, bool* tied) {
+    const __m256d signMask = _mm256_set1_pd(-0.0);
+    const __m256d m = _mm256_set1_pd(mean);
+    double best = -1.0;
+    size_t bestBlock = 0;
+    bool crossTie = false;
+    for (size_t start = 0; start < size; start += kBlockSize) {
+        size_t end = std::min(start + kBlockSize, size);
+        __m256d a0 = _mm256_set1_pd(-1.0), a1 = _mm256_set1_pd(-1.0);
+        size_t i = start;
+        for (; i + 8 <= end; i += 8) {
+            __m256d r0 = _mm256_andnot_pd(signMask, _mm256_sub_pd(loadAvx2(values + i), m));
+            __m256d r1 = _mm256_andnot_pd(signMask, _mm256_sub_pd(loadAvx2(values + i + 4), m));
+            a0 = _mm256_max_pd(a0, r0);
+            a1 = _mm256_max_pd(a1, r1);
+        }
+        double blockMax = hmaxAvx2(_mm256_max_pd(a0, a1));
+        for (; i < end; i++) blockMax = std::max(blockMax, std::fabs(values[i] - mean));
+
+        if (blockMax > best) { best = blockMax; bestBlock = start; crossTie = false; }
+        else if (blockMax == best) crossTie = true;
+    }
+    return resolveBlock(values, size, mean, best, bestBlock, crossTie, maxRes, tied);
+}
+
+template <typename T>
+__attribute__((target("avx2")))
+static void zscoresAvx2(const T* values, size_t size, double mean, double sd, double* zscores) {
+    double invSd = 1.0 / sd;
+    const __m256d m = _mm256_set1_pd(mean);
+    const __m256d s = _mm256_set1_pd(invSd);
+    size_t i = 0;
+    for (; i + 4 <= size; i += 4) {
+        _mm256_storeu_pd(zscores + i, _mm256_mul_pd(_mm256_sub_pd(loadAvx2(values + i), m), s));
+    }
+    for (; i < size; i++) zscores[i] = (values[i] - mean) * invSd;
+}
+
+// ---- AVX-512 ----
+
+// Loads 8 values widened to double (int64 conversion would need AVX-512DQ)
+__attribute__((target("avx512f")))
+static inline __m512d loadAvx512(const double* p) {
+    return _mm512_loadu_pd(p);
+}
+
+__attribute__((target("avx512f")))
+static inline __m512d loadAvx512(const float* p) {
+    return _mm512_cvtps_pd(_mm256_loadu_ps(p));
+}
+
+__attribute__((target("avx512f")))
+static inline __m512d loadAvx512(const int32_t* p) {
+    return _mm512_cvtepi32_pd(_mm256_loadu_si256(reinterpret_cast<const __m256i*>(p)));
+}
+
+__attribute__((target("avx512f")))
+static inline __m512d loadAvx512(const int64_t* p) {
+    return _mm512_set_pd((double)p[7], (double)p[6], (double)p[5], (double)p[4],
+                         (double)p[3], (double)p[2], (double)p[1], (double)p[0]);
+}
+
+template <typename T>
+__attribute__((target("avx512f")))
+static void meanM2Avx512(const T* arr, size_t size, double* mean, double* M2) {
+    size_t n = 0;
+    *mean = 0.0;
+    *M2 = 0.0;
+    for (size_t start = 0; start < size; start += kBlockSize) {
+        size_t end = std::min(start + kBlockSize, size);
+        size_t nb = end - start;
+
+        __m512d s0 = _mm512_setzero_pd(), s1 = _mm512_setzero_pd();
+        size_t i = start;
+        for (; i + 16 <= end; i += 16) {
+            s0 = _mm512_add_pd(s0, loadAvx512(arr + i));
+            s1 = _mm512_add_pd(s1, loadAvx512(arr + i + 8));
+        }
+        double sum = _mm512_reduce_add_pd(_mm512_add_pd(s0, s1));
+        for (; i < end; i++) sum += arr[i];
+        double mb = sum / nb;
+
+        __m512d m = _mm512_set1_pd(mb);
+        __m512d q0 = _mm512_setzero_pd(), q1 = _mm512_setzero_pd();
+        i = start;
+        for (; i + 16 <= end; i += 16) {
+            __m512d d0 = _mm512_sub_pd(loadAvx512(arr + i), m);
+            __m512d d1 = _mm512_sub_pd(loadAvx512(arr + i + 8), m);
+            q0 = _mm512_add_pd(q0, _mm512_mul_pd(d0, d0));
+            q1 = _mm512_add_pd(q1, _mm512_mul_pd(d1, d1));
+        }
+        double M2b = _mm512_reduce_add_pd(_mm512_add_pd(q0, q1));
+        for (; i < end; i++) {
+            double d = arr[i] - mb;
+            M2b += d * d;
+        }
+        mergeMeanM2(&n, mean, M2, nb, mb, M2b);
+    }
+}
+
+template <typename T>
+__attribute__((target("avx512f")))
+static size_t argmaxResidualAvx512(const T* values, size_t size, double mean,
+                                   double* maxRes, bool* tied) {
+    const __m512d m = _mm512_set1_pd(mean);
+    double best = -1.0;
+    size_t bestBlock = 0;
+    bool crossTie = false;
+    for (size_t start = 0; start < size; start += kBlockSize) {
+        size_t end = std::min(start + kBlockSize, size);
+        __m512d a0 = _mm512_set1_pd(-1.0), a1 = _mm512_set1_pd(-1.0);
+        size_t i = start;
+        for (; i + 16 <= end; i += 16) {
+            a0 = _mm512_max_pd(a0, _mm512_abs_pd(_mm512_sub_pd(loadAvx512(values + i), m)));
+            a1 = _mm512_max_pd(a1, _mm512_abs_pd(_mm512_sub_pd(loadAvx512(values + i + 8), m)));
+        }
+        double blockMax = _mm512_reduce_max_pd(_mm512_max_pd(a0, a1));
+        for (; i < end; i++) blockMax = std::max(blockMax, std::fabs(values[i] - mean));
+
+        if (blockMax > best) { best = blockMax; bestBlock = start; crossTie = false; }
+        else if (blockMax == best) crossTie = true;
+    }
+    return resolveBlock(values, size, mean, best, bestBlock, crossTie, maxRes, tied);
+}
+
+template <typename T>
+__attribute__((target("avx512f")))
+static void zscoresAvx512(const T* values, size_t size, double mean, double sd, double* zscores) {
+    double invSd = 1.0 / sd;
+    const __m512d m = _mm512_set1_pd(mean);
+    const __m512d s = _mm512_set1_pd(invSd);
+    size_t i = 0;
+    for (; i + 8 <= size; i += 8) {
+        _mm512_storeu_pd(zscores + i, _mm512_mul_pd(_mm512_sub_pd(loadAvx512(values + i), m), s));
+    }
+    for (; i < size; i++) zscores[i] = (values[i] - mean) * invSd;
+}
+
+#endif // GRUBBS_X86_DISPATCH
+
+// ---- dispatch ----
+
+template <typename T>
+struct KernelTable {
+    void (*meanM2)(const T*, size_t, double*, double*);
+    size_t (*argmaxResidual)(const T*, size_t, double, double*, bool*);
+    void (*zscores)(const T*, size_t, double, double, double*);
+};
+
+template <typename T>
+static const KernelTable<T>& kernelsFor(SimdLevel level) {
+    static const KernelTable<T> scalarKernels = {meanM2Scalar<T>, argmaxResidualScalar<T>,
+                                                 zscoresScalar<T>};
+#ifdef GRUBBS_X86_DISPATCH
+    static const KernelTable<T> avx2Kernels = {meanM2Avx2<T>, argmaxResidualAvx2<T>, zscoresAvx2<T>};
+    static const KernelTable<T> avx512Kernels = {meanM2Avx512<T>, argmaxResidualAvx512<T>,
+                                                 zscoresAvx512<T>};
+    if (level == SIMD_AVX512) return avx512Kernels;
+    if (level == SIMD_AVX2) return avx2Kernels;
+#endif
+    (void)level;
+    return scalarKernels;
+}
+
+SimdLevel detectSimdLevel() {
+#ifdef GRUBBS_X86_DISPATCH
+    __builtin_cpu_init();
+    if (__builtin_cpu_supports("avx512f")) return SIMD_AVX512;
+    if (__builtin_cpu_supports("avx2")) return SIMD_AVX2;
+#endif
+    return SIMD_SCALAR;
+}
+
+static std::atomic<SimdLevel>& activeLevel() {
+    static std::atomic<SimdLevel> level(detectSimdLevel());
+    return level;
+}
+
+SimdLevel activeSimdLevel() {
+    return activeLevel().load(std::memory_order_relaxed);
+}
+
+void setSimdLevel(SimdLevel level) {
+    activeLevel().store(std::min(level, detectSimdLevel()), std::memory_order_relaxed);
+}
+
+template <typename T>
+void kernelMeanM2(const T* arr, size_t size, double* mean, double* M2) {
+    kernelsFor<T>(activeSimdLevel()).meanM2(arr, size, mean, M2);
+}
+
+template <typename T>
+size_t kernelArgmaxResidual(const T* values, size_t size, double mean,
+                            double* maxRes, bool* tied) {
+    return kernelsFor<T>(activeSimdLevel()).argmaxResidual(values, size, mean, maxRes, tied);
+}
+
+template <typename T>
+void kernelZScores(const T* values, size_t size, double mean, double sd, double* zscores) {
+    kernelsFor<T>(activeSimdLevel()).zscores(values, size, mean, sd, zscores);
+}
+
+#define GRUBBS_INSTANTIATE_KERNELS(T)                                                        \
+    template void kernelMeanM2<T>(const T*, size_t, double*, double*);                       \
+    template size_t kernelArgmaxResidual<T>(const T*, size_t, double, double*, bool*);       \
+    template void kernelZScores<T>(const T*, size_t, double, double, double*);
+
+GRUBBS_INSTANTIATE_KERNELS(double)
+GRUBBS_INSTANTIATE_KERNELS(float)
+GRUBBS_INSTANTIATE_KERNELS(int32_t)
+GRUBBS_INSTANTIATE_KERNELS(int64_t)
@@ -0,0 +1,41 @@
+#ifndef SIMDKERNELS_H
+#define SIMDKERNELS_H
+
+#include <cstddef>
+
+// Instruction sets the kernels below are compiled for. The best one the CPU
+// supports is picked at first use; non-x86 builds always run SIMD_SCALAR.
+enum SimdLevel {
+    SIMD_SCALAR,
+    SIMD_AVX2,
+    SIMD_AVX512
+};
+
+SimdLevel detectSimdLevel();
+SimdLevel activeSimdLevel();
+// Forces a level (clamped to what the CPU supports), e.g. to compare against scalar
+void setSimdLevel(SimdLevel level);
+
+// The kernels below are instantiated for double, float, int32_t and int64_t
+// input. Values are widened to double as they are loaded, so every type uses
+// the same double arithmetic and no converted copy of the input is made.
+
+// Mean and M2 (sum of squared deviations) over arr. Works in cache-sized
+// blocks with a two-pass sum per block, merged with Chan's parallel update.
+template <typename T>
+void kernelMeanM2(const T* arr, size_t size, double* mean, double* M2);
+
+// Chan et al. merge of a block (count nb, mean mb, M2 M2b) into running totals
+void mergeMeanM2(size_t* n, double* mean, double* M2, size_t nb, double mb, double M2b);
+
+// Index of the first element with the largest |x - mean|. *tied is set when
+// more than one element reaches *maxRes, so callers can apply their own tie-break.
+template <typename T>
+size_t kernelArgmaxResidual(const T* values, size_t size, double mean,
+                            double* maxRes, bool* tied);
+
+// zscores[i] = (values[i] - mean) * (1 / sd)
+template <typename T>
+void kernelZScores(const T* values, size_t size, double mean, double sd, double* zscores);
+
+#endif // SIMDKERNELS_H
@@ -0,0 +1,121 @@
+#include "streamingGrubbs.hpp"
+#include "mainFunctions.hpp"
+#include "criticalValues.hpp"
+#include "simdKernels.hpp"
+#include <cmath>
+#include <iterator>
+#include <limits>
+#include <stdexcept>
+
+GrubbsStream::GrubbsStream(size_t capacity, double alpha)
+    : alphaValue(alpha), ring(capacity),
+      criticalValues(capacity + 1, std::numeric_limits<double>::quiet_NaN()) {
+    if (capacity < 3) throw std::invalid_argument("GrubbsStream capacity must be at least 3");
+}
+
+void GrubbsStream::reset() {
+    head = 0;
+    count = 0;
+    nextSeq = 0;
+    sinceRecompute = 0;
+    meanValue = 0.0;
+    M2 = 0.0;
+    ordered.clear();
+}
+
+double GrubbsStream::stdDev() const {
+    return (count > 1) ? std::sqrt(M2 / count) : 0.0;
+}
+
+// Every push walks the same n values, so G is kept per stream
+double GrubbsStream::criticalValue(size_t n) {
+    double& G = criticalValues[n];
+    if (std::isnan(G)) G = grubbsCriticalValue(alphaValue, n);
+    return G;
+}
+
+// Add/remove updates drift slowly; rebuild from the window once per lap of the ring
+void GrubbsStream::recomputeStats() {
+    if (count == ring.size()) {
+        kernelMeanM2(ring.data(), count, &meanValue, &M2);
+    } else {
+        meanValue = 0.0;
+        M2 = 0.0;
+        for (size_t i = 0; i < count; i++) addWelford(ring[(head + i) % ring.size()], i, &meanValue, &M2);
+    }
+    sinceRecompute = 0;
+}
+
+int GrubbsStream::push(double value, double* zscore, bool* isOutlier) {
+    if (zscore) *zscore = std::numeric_limits<double>::quiet_NaN();
+    if (isOutlier) *isOutlier = false;
+    // A NaN would break the ordered set's comparisons and poison the running
+    // statistics, so gaps are skipped before anything is touched
+    if (!std::isfinite(value)) return -1;
+
+    size_t cap = ring.size();
+    if (count == cap) {
+        double oldest = ring[head];
+        ordered.erase({oldest, nextSeq - count});
+        if (count > 1) {
+            removeWelford(oldest, count, &meanValue, &M2);
+        } else {
+            meanValue = M2 = 0.0;
+        }
+        head = (head + 1) % cap;
+        count--;
+    }
+
+    ring[(head + count) % cap] = value;
+    addWelford(value, count, &meanValue, &M2);
+    count++;
+    uint64_t seq = nextSeq++;
+    ordered.emplace(value, seq);
+    if (++sinceRecompute >= cap) recomputeStats();
+
+    if (count < 3 || M2 <= 0.0) return -1;
+
+    // Same loop as the sorted engine in performGrubbs, walking in from both
+    // ends of the ordered window on a copy of the running statistics
+    double cleanMean = meanValue, cleanM2 = M2;
+    size_t n = count;
+    auto low = ordered.begin();
+    auto high = std::prev(ordered.end());
+    bool removedNew = false;
+    while (n > 2) {
+        double stdValue = std::sqrt(cleanM2 / n);
+        if (stdValue == 0.0) break;
+
+        double GFactor = criticalValue(n);
+
+        double rLow = std::fabs(low->first - cleanMean);
+        double rHigh = std::fabs(high->first - cleanMean);
+        bool takeHigh = rHigh > rLow ||
+            (rHigh == rLow && preferOnTie(high->first, high->second, low->first, low->second, cleanMean));
+        double maxRes = takeHigh ? rHigh : rLow;
+
+        if (!(maxRes > GFactor)) break;
+
+        auto removed = takeHigh ? high : low;
+        removeWelford(removed->first, n, &cleanMean, &cleanM2);
+        if (removed->second == seq) removedNew = true;
+        if (takeHigh) --high; else ++low;
+        n--;
+    }
+
+    double cleanSd = std::sqrt(cleanM2 / n);
+    if (cleanSd == 0.0) return -1;
+    if (zscore) *zscore = calcZScore(cleanMean, cleanSd, value);
+    if (isOutlier) *isOutlier = removedNew;
+    return 0;
+}
+
+int GrubbsStream::pushMany(const double* values, size_t valueCount, double* zscores, unsigned char* outliers) {
+    if (valueCount > 0 && (!values || !zscores)) return -1;
+    for (size_t i = 0; i < valueCount; i++) {
+        bool isOutlier;
+        push(values[i], &zscores[i], &isOutlier);
+        if (outliers) outliers[i] = isOutlier;
+    }
+    return 0;
+}
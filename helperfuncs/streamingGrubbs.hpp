@@ -0,0 +1,53 @@
+#ifndef STREAMINGGRUBBS_H
+#define STREAMINGGRUBBS_H
+
+#include <cstddef>
+#include <cstdint>
+#include <set>
+#include <utility>
+#include <vector>
+
+// Grubbs test over a sliding window of the most recent `capacity` points.
+// The running mean/M2 is kept with the add/remove Welford updates and the
+// window is mirrored in an ordered set, so each push costs O(log N) plus one
+// O(1) step per outlier currently in the window, instead of a full rerun.
+// Not thread-safe; use one instance per stream.
+class GrubbsStream {
+public:
+    explicit GrubbsStream(size_t capacity, double alpha = 0.05);
+
+    // Adds value, evicting the oldest point once the window is full, and tests
+    // the window. Fills the new point's z-score against the clean window and
+    // whether it was removed as an outlier. Returns -1 (zscore NaN) while the
+    // window has fewer than 3 points or zero spread. NaN and infinite values
+    // also return -1 and leave the window untouched.
+    int push(double value, double* zscore, bool* isOutlier);
+    // push for each value in turn; outliers (optional) gets 0/1 per value
+    int pushMany(const double* values, size_t valueCount, double* zscores, unsigned char* outliers);
+    void reset();
+
+    size_t size() const { return count; }
+    size_t capacity() const { return ring.size(); }
+    double alpha() const { return alphaValue; }
+    // Statistics of the whole current window, outliers included
+    double mean() const { return meanValue; }
+    double stdDev() const;
+
+private:
+    void recomputeStats();
+    double criticalValue(size_t n);
+
+    double alphaValue;
+    std::vector<double> ring;
+    size_t head = 0;           // slot of the oldest point
+    size_t count = 0;
+    uint64_t nextSeq = 0;      // arrival number, breaks ties like an array index
+    size_t sinceRecompute = 0;
+
+    double meanValue = 0.0;
+    double M2 = 0.0;
+    std::set<std::pair<double, uint64_t>> ordered;
+    std::vector<double> criticalValues;   // G(alpha, n) by n, NaN until first use
+};
+
+#endif // STREAMINGGRUBBS_H
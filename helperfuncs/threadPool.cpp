@@ -0,0 +1,226 @@
+#include "threadPool.hpp"
+#include "simdKernels.hpp"
+#include "grubbsStats.hpp"
+#include <algorithm>
+#include <cstdint>
+
+// Elements per chunk for the parallel passes (a multiple of the kernel block)
+static const size_t kParallelChunk = size_t(1) << 16;
+
+// Slot of the current thread while it runs pool work, otherwise -1
+static thread_local long currentSlot = -1;
+
+ThreadPool::ThreadPool(size_t threads)
+    : participants(std::max<size_t>(threads, 1)),
+      ranges(new ChunkRange[std::max<size_t>(threads, 1)]) {
+    for (size_t slot = 1; slot < participants; slot++) {
+        workers.emplace_back(&ThreadPool::workerLoop, this, slot);
+    }
+}
+
+ThreadPool::~ThreadPool() {
+    {
+        std::lock_guard<std::mutex> lock(stateMutex);
+        stopping = true;
+    }
+    wake.notify_all();
+    for (auto& worker : workers) worker.join();
+}
+
+void ThreadPool::workerLoop(size_t slot) {
+    currentSlot = (long)slot;
+    size_t seen = 0;
+    while (true) {
+        {
+            std::unique_lock<std::mutex> lock(stateMutex);
+            wake.wait(lock, [&] { return stopping || generation != seen; });
+            if (stopping) return;
+            seen = generation;
+        }
+        while (runOne(slot)) {}
+    }
+}
+
+bool ThreadPool::runOne(size_t slot) {
+    size_t chunk = 0;
+    bool found = false;
+    for (size_t k = 0; k < participants && !found; k++) {
+        ChunkRange& range = ranges[(slot + k) % participants];
+        std::lock_guard<std::mutex> lock(range.mutex);
+        if (range.begin == range.end) continue;
+        chunk = (k == 0) ? range.begin++ : --range.end;
+        found = true;
+    }
+    if (!found) return false;
+
+    try {
+        size_t begin = chunk * jobGrain;
+        job(jobContext, begin, std::min(begin + jobGrain, jobCount), slot);
+    } catch (...) {
+        std::lock_guard<std::mutex> lock(errorMutex);
+        if (!error) error = std::current_exception();
+    }
+
+    if (remaining.fetch_sub(1, std::memory_order_acq_rel) == 1) {
+        std::lock_guard<std::mutex> lock(stateMutex);
+        finished.notify_all();
+    }
+    return true;
+}
+
+void ThreadPool::run(size_t count, size_t grain, ChunkFn fn, void* context) {
+    if (count == 0) return;
+    grain = std::max<size_t>(grain, 1);
+
+    if (currentSlot >= 0 || participants == 1 || count <= grain) {
+        // Run as slot 0 when not already in a task, so calls nested in fn stay
+        // inline too instead of sharing slot 0 with a second dispatch
+        long previous = currentSlot;
+        size_t slot = previous >= 0 ? (size_t)previous : 0;
+        currentSlot = (long)slot;
+        try {
+            for (size_t begin = 0; begin < count; begin += grain) {
+                fn(context, begin, std::min(begin + grain, count), slot);
+            }
+        } catch (...) {
+            currentSlot = previous;
+            throw;
+        }
+        currentSlot = previous;
+        return;
+    }
+
+    std::lock_guard<std::mutex> jobLock(jobMutex);
+    job = fn;
+    jobContext = context;
+    error = nullptr;
+
+    jobCount = count;
+    jobGrain = grain;
+
+    size_t chunks = (count + grain - 1) / grain;
+    remaining.store(chunks, std::memory_order_relaxed);
+    for (size_t p = 0; p < participants; p++) {
+        std::lock_guard<std::mutex> lock(ranges[p].mutex);
+        ranges[p].begin = chunks * p / participants;
+        ranges[p].end = chunks * (p + 1) / participants;
+    }
+    {
+        std::lock_guard<std::mutex> lock(stateMutex);
+        generation++;
+    }
+    wake.notify_all();
+
+    currentSlot = 0;
+    while (runOne(0)) {}
+    currentSlot = -1;
+
+    {
+        std::unique_lock<std::mutex> lock(stateMutex);
+        finished.wait(lock, [&] { return remaining.load(std::memory_order_acquire) == 0; });
+    }
+    job = nullptr;
+    jobContext = nullptr;
+    if (error) std::rethrow_exception(error);
+}
+
+ThreadPool& globalThreadPool() {
+    static ThreadPool pool(std::thread::hardware_concurrency());
+    return pool;
+}
+
+template <typename T>
+void parallelMeanM2(const T* arr, size_t size, double* mean, double* M2) {
+    if (size < kParallelMinSize) {
+        kernelMeanM2(arr, size, mean, M2);
+        return;
+    }
+
+    size_t chunks = (size + kParallelChunk - 1) / kParallelChunk;
+    // Per-chunk results live in the caller's thread_local buffers; workers
+    // reach them through the raw pointers captured below
+    thread_local std::vector<double> meanBuffer, M2Buffer;
+    if (meanBuffer.size() < chunks) {
+        recordGrubbsAllocation((chunks - meanBuffer.size()) * 2 * sizeof(double));
+        meanBuffer.resize(chunks);
+        M2Buffer.resize(chunks);
+    }
+    double* means = meanBuffer.data();
+    double* M2s = M2Buffer.data();
+    globalThreadPool().parallelFor(chunks, 1, [=](size_t begin, size_t end, size_t) {
+        for (size_t c = begin; c < end; c++) {
+            size_t start = c * kParallelChunk;
+            kernelMeanM2(arr + start, std::min(kParallelChunk, size - start), &means[c], &M2s[c]);
+        }
+    });
+
+    // Merge in chunk order so the result is the same for any thread count
+    size_t n = 0;
+    *mean = 0.0;
+    *M2 = 0.0;
+    for (size_t c = 0; c < chunks; c++) {
+        size_t start = c * kParallelChunk;
+        mergeMeanM2(&n, mean, M2, std::min(kParallelChunk, size - start), means[c], M2s[c]);
+    }
+}
+
+template <typename T>
+size_t parallelArgmaxResidual(const T* values, size_t size, double mean,
+                              double* maxRes, bool* tied) {
+    if (size < kParallelMinSize) return kernelArgmaxResidual(values, size, mean, maxRes, tied);
+
+    size_t chunks = (size + kParallelChunk - 1) / kParallelChunk;
+    thread_local std::vector<size_t> indexBuffer;
+    thread_local std::vector<double> maxBuffer;
+    thread_local std::vector<unsigned char> tieBuffer;
+    if (indexBuffer.size() < chunks) {
+        recordGrubbsAllocation((chunks - indexBuffer.size()) *
+                               (sizeof(size_t) + sizeof(double) + sizeof(unsigned char)));
+        indexBuffer.resize(chunks);
+        maxBuffer.resize(chunks);
+        tieBuffer.resize(chunks);
+    }
+    size_t* indices = indexBuffer.data();
+    double* maxima = maxBuffer.data();
+    unsigned char* ties = tieBuffer.data();
+    globalThreadPool().parallelFor(chunks, 1, [=](size_t begin, size_t end, size_t) {
+        for (size_t c = begin; c < end; c++) {
+            size_t start = c * kParallelChunk;
+            bool chunkTied;
+            indices[c] = start + kernelArgmaxResidual(values + start, std::min(kParallelChunk, size - start),
+                                                      mean, &maxima[c], &chunkTied);
+            ties[c] = chunkTied;
+        }
+    });
+
+    size_t best = 0;
+    bool anyTie = ties[0];
+    for (size_t c = 1; c < chunks; c++) {
+        if (maxima[c] > maxima[best]) { best = c; anyTie = ties[c]; }
+        else if (maxima[c] == maxima[best]) anyTie = true;
+    }
+    *maxRes = maxima[best];
+    *tied = anyTie;
+    return indices[best];
+}
+
+template <typename T>
+void parallelZScores(const T* values, size_t size, double mean, double sd, double* zscores) {
+    if (size < kParallelMinSize) {
+        kernelZScores(values, size, mean, sd, zscores);
+        return;
+    }
+    globalThreadPool().parallelFor(size, kParallelChunk, [=](size_t begin, size_t end, size_t) {
+        kernelZScores(values + begin, end - begin, mean, sd, zscores + begin);
+    });
+}
+
+#define GRUBBS_INSTANTIATE_PARALLEL(T)                                                       \
+    template void parallelMeanM2<T>(const T*, size_t, double*, double*);                     \
+    template size_t parallelArgmaxResidual<T>(const T*, size_t, double, double*, bool*);     \
+    template void parallelZScores<T>(const T*, size_t, double, double, double*);
+
+GRUBBS_INSTANTIATE_PARALLEL(double)
+GRUBBS_INSTANTIATE_PARALLEL(float)
+GRUBBS_INSTANTIATE_PARALLEL(int32_t)
+GRUBBS_INSTANTIATE_PARALLEL(int64_t)
@@ -0,0 +1,88 @@
+#ifndef THREADPOOL_H
+#define THREADPOOL_H
+
+#include <atomic>
+#include <condition_variable>
+#include <cstddef>
+#include <exception>
+#include <memory>
+#include <mutex>
+#include <thread>
+#include <type_traits>
+#include <vector>
+
+// Fixed set of worker threads. Each job's chunks are dealt out as one
+// contiguous range per participant; a participant takes chunks from the front
+// of its own range and, once it runs dry, steals from the back of the others,
+// so uneven chunks (e.g. groups of very different sizes) still balance out.
+class ThreadPool {
+public:
+    // threads counts every participant, including the thread calling parallelFor
+    explicit ThreadPool(size_t threads);
+    ~ThreadPool();
+
+    size_t size() const { return participants; }
+
+    // Runs fn(begin, end, slot) over [0, count) in chunks of at most grain.
+    // slot < size() identifies the running thread, for per-thread scratch.
+    // Blocks until every chunk is done and rethrows the first exception.
+    // Calls made from inside a pool task run inline on the calling thread.
+    // fn is only referenced, never copied, so dispatch does not allocate.
+    template <typename Fn>
+    void parallelFor(size_t count, size_t grain, Fn&& fn) {
+        using Callable = typename std::remove_reference<Fn>::type;
+        run(count, grain, [](void* context, size_t begin, size_t end, size_t slot) {
+            (*static_cast<Callable*>(context))(begin, end, slot);
+        }, const_cast<void*>(static_cast<const void*>(&fn)));
+    }
+
+private:
+    using ChunkFn = void (*)(void* context, size_t begin, size_t end, size_t slot);
+
+    void run(size_t count, size_t grain, ChunkFn fn, void* context);
+    struct ChunkRange {
+        std::mutex mutex;
+        size_t begin = 0;   // next chunk index to take from the front
+        size_t end = 0;     // one past the last chunk index
+    };
+
+    void workerLoop(size_t slot);
+    bool runOne(size_t slot);
+
+    size_t participants;
+    std::vector<std::thread> workers;
+    std::unique_ptr<ChunkRange[]> ranges;
+
+    std::mutex jobMutex;                // one parallelFor at a time
+    std::mutex stateMutex;
+    std::condition_variable wake;
+    std::condition_variable finished;
+    size_t generation = 0;
+    bool stopping = false;
+
+    ChunkFn job = nullptr;
+    void* jobContext = nullptr;
+    size_t jobCount = 0;
+    size_t jobGrain = 1;
+    std::atomic<size_t> remaining{0};
+    std::mutex errorMutex;
+    std::exception_ptr error;
+};
+
+// Process-wide pool sized to the hardware concurrency
+ThreadPool& globalThreadPool();
+
+// Below this many elements the parallel passes just call the serial kernel
+const size_t kParallelMinSize = size_t(1) << 20;
+
+// Pool-split versions of the simdKernels passes, for the same input types.
+// Chunk boundaries are fixed, so results do not depend on the number of threads.
+template <typename T>
+void parallelMeanM2(const T* arr, size_t size, double* mean, double* M2);
+template <typename T>
+size_t parallelArgmaxResidual(const T* values, size_t size, double mean,
+                              double* maxRes, bool* tied);
+template <typename T>
+void parallelZScores(const T* values, size_t size, double mean, double sd, double* zscores);
+
+#endif // THREADPOOL_H
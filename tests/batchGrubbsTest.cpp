@@ -0,0 +1,103 @@
+#include "testUtil.hpp"
+#include "batchGrubbs.hpp"
+#include "threadPool.hpp"
+#include <atomic>
+#include <cmath>
+#include <cstring>
+#include <exception>
+#include <limits>
+#include <stdexcept>
+#include <vector>
+
+static bool sameBits(double a, double b) {
+    return std::memcmp(&a, &b, sizeof(double)) == 0;
+}
+
+// Every group must come out exactly as a separate performGrubbs call on it, and
+// groups that cannot be tested must fail cleanly without touching the others
+GRUBBS_TEST(batchMatchesPerGroupRuns) {
+    std::vector<double> values;
+    std::vector<size_t> offsets = {0};
+    std::vector<bool> mustFail;
+    auto addGroup = [&](const std::vector<double>& group, bool fails) {
+        values.insert(values.end(), group.begin(), group.end());
+        offsets.push_back(values.size());
+        mustFail.push_back(fails);
+    };
+    addGroup({}, true);
+    addGroup({1.0, 2.0}, true);
+    addGroup(std::vector<double>(50, 7.0), true);
+    std::vector<double> withNaN = makeContaminatedData(100, 0.0, 3);
+    withNaN[40] = std::numeric_limits<double>::quiet_NaN();
+    addGroup(withNaN, true);
+    for (size_t g = 0; g < 200; g++) {
+        addGroup(makeContaminatedData(20 + (g * 37) % 3000, 0.02, 100 + g), false);
+    }
+    // Left for the serial pass, where its own passes use the whole pool
+    addGroup(makeContaminatedData(kParallelMinSize + 4321, 0.001, 7), false);
+    addGroup(makeContaminatedData(1000, 0.01, 8), false);
+
+    size_t groupCount = mustFail.size();
+    std::vector<double> zscores(values.size()), means(groupCount), sds(groupCount);
+    std::vector<unsigned char> mask(values.size()), ok(groupCount);
+    CHECK(performGrubbsBatch(values.data(), offsets.data(), groupCount, 0.05, zscores.data(),
+                             mask.data(), means.data(), sds.data(), ok.data()) == 0);
+
+    for (size_t g = 0; g < groupCount; g++) {
+        size_t begin = offsets[g], size = offsets[g + 1] - begin;
+        std::vector<double> expectedZ(size);
+        std::vector<unsigned char> expectedMask(size);
+        double expectedMean = 0.0, expectedSd = 0.0;
+        int ret = -1;
+        try {
+            GrubbsQuietErrors quiet;
+            ret = performGrubbs(values.data() + begin, size, expectedZ.data(), 0.05,
+                                expectedMask.data(), &expectedMean, &expectedSd);
+        } catch (const std::exception&) {
+        }
+
+        bool same = (ok[g] != 0) == (ret == 0) && (ret == 0) != mustFail[g];
+        for (size_t i = 0; i < size && same; i++) {
+            same = ret == 0 ? sameBits(zscores[begin + i], expectedZ[i]) &&
+                                  mask[begin + i] == expectedMask[i]
+                            : std::isnan(zscores[begin + i]) && mask[begin + i] == 0;
+        }
+        same = same && (ret == 0 ? sameBits(means[g], expectedMean) && sameBits(sds[g], expectedSd)
+                                 : std::isnan(means[g]) && std::isnan(sds[g]));
+        CHECK_MSG(same, "group %zu (%zu points, ret %d) differs", g, size, ret);
+    }
+}
+
+// A four-thread pool, whatever the machine has, must run every chunk exactly
+// once on a valid slot, finish the other chunks when one throws, rethrow that
+// exception and stay usable afterwards
+GRUBBS_TEST(threadPoolRunsEveryChunkOnce) {
+    ThreadPool pool(4);
+    CHECK(pool.size() == 4);
+    for (size_t round = 0; round < 200; round++) {
+        size_t count = 1 + (round * 7919) % 5000, grain = 1 + round % 13;
+        std::vector<std::atomic<int>> hits(count);
+        std::atomic<bool> badSlot{false};
+        size_t throwAt = (round % 3 == 0) ? (round * 31) % count : count;
+        bool threw = false;
+        try {
+            pool.parallelFor(count, grain, [&](size_t begin, size_t end, size_t slot) {
+                if (slot >= pool.size()) badSlot = true;
+                for (size_t i = begin; i < end; i++) hits[i]++;
+                // Nested calls run inline on the same slot
+                pool.parallelFor(2, 1, [&](size_t, size_t, size_t inner) {
+                    if (inner != slot) badSlot = true;
+                });
+                if (throwAt >= begin && throwAt < end) throw std::runtime_error("chunk failed");
+            });
+        } catch (const std::runtime_error&) {
+            threw = true;
+        }
+
+        size_t wrong = 0;
+        for (size_t i = 0; i < count; i++) wrong += hits[i] != 1;
+        CHECK_MSG(wrong == 0 && !badSlot && threw == (throwAt < count),
+                  "round %zu: %zu of %zu indices not run once, bad slot %d, threw %d", round,
+                  wrong, count, (int)badSlot.load(), (int)threw);
+    }
+}
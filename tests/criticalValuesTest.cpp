@@ -0,0 +1,56 @@
+#include "testUtil.hpp"
+#include "criticalValues.hpp"
+#include "mainFunctions.hpp"
+#include <cmath>
+
+static const double kAlphas[] = {0.001, 0.01, 0.05, 0.1, 0.5};
+
+// Documented bound between approxTDist and Boost's quantile (criticalValues.hpp)
+static const double kApproxTolerance = 1e-15;
+static const double kMaxCheckedN = 1e9;
+
+static double relativeError(double a, double b) {
+    return std::fabs(a - b) / std::fabs(b);
+}
+
+// Below kApproxTDistMinN the memo table stores Boost's value, so cached and
+// uncached lookups must match it exactly.
+GRUBBS_TEST(memoTableMatchesBoost) {
+    for (double alpha : kAlphas) {
+        for (size_t n = 3; n < kApproxTDistMinN; n++) {
+            double expected = calcG(calcTDist(alpha, n), n);
+            double first = grubbsCriticalValue(alpha, n);
+            double cached = grubbsCriticalValue(alpha, n);
+            CHECK_MSG(first == expected && cached == expected,
+                      "alpha=%g n=%zu got %.17g / %.17g, expected %.17g",
+                      alpha, n, first, cached, expected);
+        }
+    }
+}
+
+GRUBBS_TEST(precomputeFillsMemoTable) {
+    const double alpha = 0.025;
+    precomputeCriticalValues(&alpha, 1);
+    for (size_t n = 3; n < kApproxTDistMinN; n += 97) {
+        CHECK(grubbsCriticalValue(alpha, n) == calcG(calcTDist(alpha, n), n));
+    }
+}
+
+// Cornish-Fisher approximation from kApproxTDistMinN up to 1e9 points, the
+// range documented in criticalValues.hpp
+GRUBBS_TEST(approximationWithinTolerance) {
+    for (double alpha : kAlphas) {
+        double worst = 0.0;
+        // Geometric steps, finishing exactly on the documented upper end
+        for (double x = kApproxTDistMinN; x < kMaxCheckedN * 1.07; x *= 1.07) {
+            size_t n = (size_t)std::fmin(x, kMaxCheckedN);
+            double t = calcTDist(alpha, n);
+            double tErr = relativeError(approxTDist(alpha, n), t);
+            double gErr = relativeError(grubbsCriticalValue(alpha, n), calcG(t, n));
+            CHECK_MSG(tErr <= kApproxTolerance && gErr <= kApproxTolerance,
+                      "alpha=%g n=%zu t error %.3g, G error %.3g", alpha, n, tErr, gErr);
+            worst = std::fmax(worst, std::fmax(tErr, gErr));
+        }
+        std::printf("  alpha=%g worst relative error %.3g\n", alpha, worst);
+    }
+}
@@ -0,0 +1,206 @@
+#include "testUtil.hpp"
+#include "fileGrubbs.hpp"
+#include "mainFunctions.hpp"
+#include <cmath>
+#include <cstdint>
+#include <cstdio>
+#include <cstring>
+#include <limits>
+#include <fstream>
+#include <string>
+#include <vector>
+#include <unistd.h>
+
+// Writes values to a fresh temporary file and removes it when done
+class TempFile {
+public:
+    template <typename T>
+    explicit TempFile(const std::vector<T>& values) {
+        char name[] = "/tmp/grubbstestsXXXXXX";
+        int fd = mkstemp(name);
+        path = name;
+        if (fd < 0) return;
+        ssize_t bytes = (ssize_t)(values.size() * sizeof(T));
+        ok = write(fd, values.data(), bytes) == bytes;
+        close(fd);
+    }
+    ~TempFile() { std::remove(path.c_str()); }
+
+    std::string path;
+    bool ok = false;
+};
+
+// The file engine must remove the same points as performGrubbs on the same data,
+// including when the candidate budget forces several passes over the file
+template <typename T>
+static void checkFileMatchesMemory(GrubbsFileFormat format, const char* label) {
+    std::vector<double> data = makeContaminatedData(300000, 0.01, 23);
+    std::vector<T> values(data.begin(), data.end());
+    TempFile file(values);
+    CHECK(file.ok);
+
+    std::vector<double> zscores(values.size());
+    std::vector<unsigned char> mask(values.size());
+    double memoryMean, memorySd;
+    CHECK(performGrubbs(values.data(), values.size(), zscores.data(), 0.05, mask.data(),
+                        &memoryMean, &memorySd) == 0);
+    size_t memoryClean = 0;
+    for (unsigned char removed : mask) memoryClean += !removed;
+
+    TempFile zscoreFile(std::vector<double>{});
+    for (size_t maxCandidates : {kFileCandidates, size_t(500)}) {
+        size_t size = 0, cleanSize = 0;
+        double cleanMean = 0.0, cleanSd = 0.0;
+        int ret = performGrubbsFile(file.path.c_str(), format, zscoreFile.path.c_str(), 0.05,
+                                    &size, &cleanSize, &cleanMean, &cleanSd, maxCandidates);
+        // The clean statistics are summed in a different order, so allow a few ulps
+        CHECK_MSG(ret == 0 && size == values.size() && cleanSize == memoryClean &&
+                  std::fabs(cleanMean - memoryMean) <= 1e-14 * memorySd &&
+                  std::fabs(cleanSd - memorySd) <= 1e-14 * memorySd,
+                  "%s K=%zu: ret %d, clean %zu vs %zu, mean %.17g vs %.17g, sd %.17g vs %.17g",
+                  label, maxCandidates, ret, cleanSize, memoryClean, cleanMean, memoryMean,
+                  cleanSd, memorySd);
+
+        std::vector<double> fileZScores(values.size());
+        std::ifstream in(zscoreFile.path, std::ios::binary);
+        in.read(reinterpret_cast<char*>(fileZScores.data()), fileZScores.size() * sizeof(double));
+        double worst = 0.0;
+        for (size_t i = 0; i < values.size(); i++) {
+            worst = std::fmax(worst, std::fabs(fileZScores[i] - zscores[i]));
+        }
+        CHECK_MSG(in && worst <= 1e-12, "%s K=%zu: worst z-score difference %.3g", label,
+                  maxCandidates, worst);
+    }
+}
+
+GRUBBS_TEST(fileMatchesInMemory) {
+    checkFileMatchesMemory<double>(GRUBBS_FILE_FLOAT64, "float64");
+    checkFileMatchesMemory<float>(GRUBBS_FILE_FLOAT32, "float32");
+}
+
+GRUBBS_TEST(fileRejectsNonFiniteValues) {
+    std::vector<double> values = makeContaminatedData(100000, 0.01, 29);
+    for (size_t i = 0; i < values.size(); i += 1000) {
+        values[i] = std::numeric_limits<double>::quiet_NaN();
+    }
+    TempFile file(values);
+    CHECK(file.ok);
+
+    size_t size = 0, cleanSize = 0;
+    double cleanMean = 0.0, cleanSd = 0.0;
+    CHECK(performGrubbsFile(file.path.c_str(), GRUBBS_FILE_FLOAT64, nullptr, 0.05, &size,
+                            &cleanSize, &cleanMean, &cleanSd, 100) == -1);
+}
+
+// Rejected inputs must not leave a zero-filled z-score file that looks valid
+GRUBBS_TEST(rejectedFileLeavesNoZScores) {
+    std::vector<double> nonFinite = makeContaminatedData(10000, 0.01, 31);
+    nonFinite[5000] = std::numeric_limits<double>::infinity();
+    std::vector<double> constant(10000, 3.0);
+
+    for (const std::vector<double>* values : {&nonFinite, &constant}) {
+        TempFile file(*values);
+        CHECK(file.ok);
+        std::string zscorePath = file.path + ".z";
+
+        size_t size = 0, cleanSize = 0;
+        double cleanMean = 0.0, cleanSd = 0.0;
+        int ret = performGrubbsFile(file.path.c_str(), GRUBBS_FILE_FLOAT64, zscorePath.c_str(),
+                                    0.05, &size, &cleanSize, &cleanMean, &cleanSd, 100);
+        bool leftOver = access(zscorePath.c_str(), F_OK) == 0;
+        std::remove(zscorePath.c_str());
+        CHECK_MSG(ret == -1 && !leftOver, "ret %d, z-score file left behind: %d", ret,
+                  (int)leftOver);
+    }
+}
+
+// Lays out a GRUBBS_FILE_HEADER file: header, padding up to dataOffset, then values
+template <typename T>
+static std::vector<unsigned char> headerFile(const std::vector<T>& values, uint64_t count,
+                                             uint64_t dataOffset) {
+    GrubbsFileHeader header = {{'G', 'R', 'B', 'C'}, 1, sizeof(T), 0, count, dataOffset};
+    std::vector<unsigned char> bytes(dataOffset + values.size() * sizeof(T), 0xAB);
+    std::memcpy(bytes.data(), &header, sizeof(header));
+    std::memcpy(bytes.data() + dataOffset, values.data(), values.size() * sizeof(T));
+    return bytes;
+}
+
+static int runFile(const std::vector<unsigned char>& bytes, size_t* size, size_t* cleanSize,
+                   double* cleanMean, double* cleanSd) {
+    TempFile file(bytes);
+    CHECK(file.ok);
+    return performGrubbsFile(file.path.c_str(), GRUBBS_FILE_HEADER, nullptr, 0.05, size,
+                             cleanSize, cleanMean, cleanSd);
+}
+
+// A header file must give the same result as the bare column it describes, reading
+// exactly count values from dataOffset and ignoring anything after them
+template <typename T>
+static void checkHeaderMatchesRaw(GrubbsFileFormat format, uint64_t dataOffset,
+                                  const char* label) {
+    std::vector<double> data = makeContaminatedData(20000, 0.01, 37);
+    std::vector<T> values(data.begin(), data.end());
+    TempFile raw(values);
+    CHECK(raw.ok);
+    size_t rawSize = 0, rawClean = 0;
+    double rawMean = 0.0, rawSd = 0.0;
+    CHECK(performGrubbsFile(raw.path.c_str(), format, nullptr, 0.05, &rawSize, &rawClean,
+                            &rawMean, &rawSd) == 0);
+
+    // Trailing NaNs past count would make the run fail if they were read
+    std::vector<T> padded = values;
+    padded.resize(values.size() + 100, std::numeric_limits<T>::quiet_NaN());
+    size_t size = 0, cleanSize = 0;
+    double cleanMean = 0.0, cleanSd = 0.0;
+    int ret = runFile(headerFile(padded, values.size(), dataOffset), &size, &cleanSize,
+                      &cleanMean, &cleanSd);
+    CHECK_MSG(ret == 0 && size == rawSize && cleanSize == rawClean &&
+              std::fabs(cleanMean - rawMean) <= 1e-14 * rawSd &&
+              std::fabs(cleanSd - rawSd) <= 1e-14 * rawSd,
+              "%s offset %llu: ret %d, size %zu vs %zu, clean %zu vs %zu", label,
+              (unsigned long long)dataOffset, ret, size, rawSize, cleanSize, rawClean);
+}
+
+GRUBBS_TEST(fileHeaderMatchesRawColumn) {
+    checkHeaderMatchesRaw<double>(GRUBBS_FILE_FLOAT64, 32, "float64");
+    checkHeaderMatchesRaw<double>(GRUBBS_FILE_FLOAT64, 4096, "float64");
+    checkHeaderMatchesRaw<float>(GRUBBS_FILE_FLOAT32, 36, "float32");
+}
+
+GRUBBS_TEST(fileRejectsInvalidHeaders) {
+    std::vector<double> values = makeContaminatedData(1000, 0.01, 41);
+    std::vector<unsigned char> valid = headerFile(values, values.size(), 64);
+    size_t size = 0, cleanSize = 0;
+    double cleanMean = 0.0, cleanSd = 0.0;
+    CHECK(runFile(valid, &size, &cleanSize, &cleanMean, &cleanSd) == 0 && size == 1000);
+
+    struct Case {
+        const char* label;
+        size_t field;       // byte offset of the field to overwrite
+        uint64_t value;
+        size_t width;
+    };
+    const Case cases[] = {
+        {"magic", 0, 0, 4},
+        {"version", 4, 2, 4},
+        {"element size", 8, 2, 4},
+        {"offset inside header", 24, 16, 8},
+        {"misaligned offset", 24, 68, 8},
+        {"offset past end", 24, valid.size() + 8, 8},
+        {"count past end", 16, 1001, 8},
+        {"huge count", 16, UINT64_MAX, 8},
+    };
+    for (const Case& c : cases) {
+        std::vector<unsigned char> bytes = valid;
+        std::memcpy(bytes.data() + c.field, &c.value, c.width);
+        CHECK_MSG(runFile(bytes, &size, &cleanSize, &cleanMean, &cleanSd) == -1,
+                  "%s was accepted", c.label);
+    }
+
+    std::vector<unsigned char> truncated(valid.begin(), valid.begin() + 20);
+    CHECK(runFile(truncated, &size, &cleanSize, &cleanMean, &cleanSd) == -1);
+
+    // A header with no values is valid but gives an empty column
+    std::vector<unsigned char> empty = headerFile(std::vector<double>{}, 0, 32);
+    CHECK(runFile(empty, &size, &cleanSize, &cleanMean, &cleanSd) == -1 && size == 0);
+}
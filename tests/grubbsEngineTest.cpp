@@ -0,0 +1,119 @@
+#include "testUtil.hpp"
+#include "grubbsEngine.hpp"
+#include "grubbsStats.hpp"
+#include "threadPool.hpp"
+#include <algorithm>
+#include <cstdint>
+#include <cstring>
+#include <thread>
+#include <vector>
+
+// Threads sharing one engine, with growing sizes and reserve() calls that
+// reallocate the workspace, must get what a private engine gives them
+GRUBBS_TEST(sharedEngineMatchesPrivateEngines) {
+    const size_t threadCount = 4, rounds = 20;
+    GrubbsEngine shared;
+    std::vector<size_t> mismatches(threadCount, 0);
+    std::vector<std::thread> threads;
+    for (size_t t = 0; t < threadCount; t++) {
+        threads.emplace_back([&, t] {
+            GrubbsEngine own;
+            for (size_t r = 0; r < rounds; r++) {
+                size_t size = 1000 + (t * rounds + r) * 997;
+                std::vector<double> values = makeContaminatedData(size, 0.01, t * 1000 + r);
+                std::vector<double> expected(size), zscores(size);
+                own.run(values.data(), size, expected.data(), 0.05);
+                if (r % 5 == 0) shared.reserve(size * 2);
+                int ret = shared.run(values.data(), size, zscores.data(), 0.05);
+                if (ret != 0 || std::memcmp(zscores.data(), expected.data(), size * sizeof(double))) {
+                    mismatches[t]++;
+                }
+
+                size_t cleanSize;
+                std::vector<double> inPlace = values;
+                shared.runInPlace(inPlace.data(), size, 0.05, &cleanSize);
+                std::vector<double> ownInPlace = values;
+                size_t ownCleanSize;
+                own.runInPlace(ownInPlace.data(), size, 0.05, &ownCleanSize);
+                if (cleanSize != ownCleanSize || inPlace != ownInPlace) mismatches[t]++;
+            }
+        });
+    }
+    for (std::thread& thread : threads) thread.join();
+    for (size_t t = 0; t < threadCount; t++) {
+        CHECK_MSG(mismatches[t] == 0, "thread %zu: %zu mismatched runs", t, mismatches[t]);
+    }
+    CHECK(shared.capacity() >= 1000 + (threadCount * rounds - 1) * 997);
+}
+
+// Once an engine has seen a size, later runs on that size allocate nothing,
+// including on the parallel path above kParallelMinSize. Every scratch
+// allocation in the core is recorded in GrubbsStats::bytesAllocated.
+GRUBBS_TEST(steadyStateRunsDoNotAllocate) {
+    for (size_t size : {size_t(1000), size_t(100000), kParallelMinSize + 12345}) {
+        std::vector<double> values = makeContaminatedData(size, 0.01, size);
+        std::vector<double> zscores(size), inPlace(size);
+        std::vector<unsigned char> mask(size);
+        size_t cleanSize;
+        GrubbsEngine engine;
+
+        // First calls size the workspace, so they must show up in the counter
+        setGrubbsStatsEnabled(true);
+        resetGrubbsStats();
+        CHECK(engine.run(values.data(), size, zscores.data(), 0.05, mask.data()) == 0);
+        inPlace = values;
+        CHECK(engine.runInPlace(inPlace.data(), size, 0.05, &cleanSize) == 0);
+        CHECK_MSG(threadGrubbsStats().bytesAllocated >= size * sizeof(double),
+                  "n=%zu: first run recorded only %zu bytes", size,
+                  threadGrubbsStats().bytesAllocated);
+
+        resetGrubbsStats();
+        int ret = engine.run(values.data(), size, zscores.data(), 0.05, mask.data());
+        inPlace = values;   // same capacity, so the copy does not allocate
+        int inPlaceRet = engine.runInPlace(inPlace.data(), size, 0.05, &cleanSize);
+        GrubbsStats stats = threadGrubbsStats();
+        setGrubbsStatsEnabled(false);
+
+        CHECK(ret == 0 && inPlaceRet == 0);
+        CHECK_MSG(stats.calls == 2 && stats.bytesAllocated == 0,
+                  "n=%zu: %zu calls, %zu bytes allocated", size, stats.calls,
+                  stats.bytesAllocated);
+    }
+}
+
+// runInPlace leaves the survivors first and the outliers last, each in input
+// order, matching performGrubbs's outlier mask and clean statistics
+GRUBBS_TEST(inPlaceOrderMatchesMask) {
+    for (double fraction : {0.0, 0.01, 0.05}) {
+        for (GrubbsMode mode : {GRUBBS_MODE_AUTO, GRUBBS_MODE_SCAN, GRUBBS_MODE_SORTED}) {
+            size_t size = 20000;
+            std::vector<double> values = makeContaminatedData(size, fraction, 41);
+            std::vector<double> zscores(size);
+            std::vector<unsigned char> mask(size);
+            double cleanMean, cleanSd;
+            CHECK(performGrubbs(values.data(), size, zscores.data(), 0.05, mask.data(),
+                                &cleanMean, &cleanSd, mode) == 0);
+
+            std::vector<double> expected, expectedZ;
+            for (int outlier = 0; outlier < 2; outlier++) {
+                for (size_t i = 0; i < size; i++) {
+                    if (mask[i] != outlier) continue;
+                    expected.push_back(values[i]);
+                    expectedZ.push_back(zscores[i]);
+                }
+            }
+            size_t expectedClean = size - std::count(mask.begin(), mask.end(), 1);
+
+            GrubbsEngine engine(mode);
+            std::vector<double> inPlace = values, inPlaceZ(size);
+            size_t cleanSize = 0;
+            double inPlaceMean = 0.0, inPlaceSd = 0.0;
+            CHECK(engine.runInPlace(inPlace.data(), size, 0.05, &cleanSize, &inPlaceMean,
+                                    &inPlaceSd, inPlaceZ.data()) == 0);
+            CHECK_MSG(cleanSize == expectedClean && inPlace == expected && inPlaceZ == expectedZ &&
+                      inPlaceMean == cleanMean && inPlaceSd == cleanSd,
+                      "fraction=%g mode=%d: clean %zu vs %zu", fraction, (int)mode, cleanSize,
+                      expectedClean);
+        }
+    }
+}
@@ -0,0 +1,215 @@
+#include "testUtil.hpp"
+#include "mainFunctions.hpp"
+#include "criticalValues.hpp"
+#include "threadPool.hpp"
+#include <cmath>
+#include <cstdint>
+#include <cstring>
+#include <exception>
+#include <limits>
+#include <random>
+#include <vector>
+
+static const GrubbsMode kModes[] = {GRUBBS_MODE_AUTO, GRUBBS_MODE_SCAN, GRUBBS_MODE_SORTED};
+static const char* kModeNames[] = {"auto", "scan", "sorted"};
+
+// ret value recorded when performGrubbs throws
+static const int kThrew = -2;
+
+struct GrubbsResult {
+    int ret;
+    std::vector<double> zscores;
+    std::vector<unsigned char> mask;
+    double cleanMean, cleanSd;
+};
+
+template <typename T, GrubbsTail tail>
+static GrubbsResult runGrubbs(const std::vector<T>& values, GrubbsMode mode) {
+    GrubbsResult result;
+    size_t size = values.size();
+    result.zscores.assign(size, 0.0);
+    result.mask.assign(size, 0);
+    result.cleanMean = result.cleanSd = 0.0;
+    // Small, heavily one-sided inputs can cascade to n = 2, where Boost throws;
+    // every mode must then throw alike
+    try {
+        result.ret = performGrubbs<T, tail>(values.data(), size, result.zscores.data(), 0.05,
+                                            result.mask.data(), &result.cleanMean,
+                                            &result.cleanSd, mode);
+    } catch (const std::exception&) {
+        result.ret = kThrew;
+    }
+    return result;
+}
+
+// Bit-for-bit comparison, so NaN outputs compare equal to themselves
+static bool sameResult(const GrubbsResult& a, const GrubbsResult& b) {
+    if (a.ret != b.ret) return false;
+    if (a.ret != 0) return true;
+    return a.mask == b.mask &&
+           !std::memcmp(a.zscores.data(), b.zscores.data(), a.zscores.size() * sizeof(double)) &&
+           !std::memcmp(&a.cleanMean, &b.cleanMean, sizeof(double)) &&
+           !std::memcmp(&a.cleanSd, &b.cleanSd, sizeof(double));
+}
+
+static std::vector<double> makeData(size_t size, double fraction, bool rounded, uint64_t seed) {
+    std::vector<double> values = makeContaminatedData(size, fraction, seed);
+    // Coarse values make many equal residuals, which exercises the tie rule
+    if (rounded) {
+        for (double& x : values) x = std::round(x * 4) / 4;
+    }
+    return values;
+}
+
+template <typename T, GrubbsTail tail>
+static void checkModesAgree(const std::vector<T>& values, const char* label) {
+    GrubbsResult first = runGrubbs<T, tail>(values, kModes[0]);
+    for (size_t m = 1; m < 3; m++) {
+        GrubbsResult other = runGrubbs<T, tail>(values, kModes[m]);
+        CHECK_MSG(sameResult(first, other), "%s n=%zu tail=%d: %s (ret %d) differs from %s (ret %d)",
+                  label, values.size(), (int)tail, kModeNames[m], other.ret, kModeNames[0],
+                  first.ret);
+    }
+}
+
+template <GrubbsTail tail>
+static void checkAllSizes() {
+    for (size_t size : {20, 63, 64, 65, 1000, 20000}) {
+        for (double fraction : {0.0, 0.01, 0.05, 0.2}) {
+            for (bool rounded : {false, true}) {
+                std::vector<double> values = makeData(size, fraction, rounded, size * 7 + rounded);
+                checkModesAgree<double, tail>(values, rounded ? "rounded" : "normal");
+            }
+        }
+    }
+}
+
+GRUBBS_TEST(modesGiveIdenticalResults) {
+    checkAllSizes<GRUBBS_TWO_SIDED>();
+    checkAllSizes<GRUBBS_UPPER>();
+    checkAllSizes<GRUBBS_LOWER>();
+
+    // Many removals: AUTO switches to the sorted engine partway through
+    std::vector<double> heavy = makeData(200000, 0.05, false, 3);
+    checkModesAgree<double, GRUBBS_TWO_SIDED>(heavy, "heavy");
+
+    std::vector<float> floats(heavy.begin(), heavy.end());
+    checkModesAgree<float, GRUBBS_TWO_SIDED>(floats, "float");
+}
+
+GRUBBS_TEST(modesRejectNonFiniteInput) {
+    const double nan = std::numeric_limits<double>::quiet_NaN();
+    const double inf = std::numeric_limits<double>::infinity();
+    std::vector<double> values = makeData(2000, 0.01, false, 11);
+
+    std::vector<double> withNaN = values;
+    for (size_t i = 0; i < withNaN.size(); i += 20) withNaN[i] = nan;
+    std::vector<double> withInf = values;
+    withInf[1234] = -inf;
+
+    for (const std::vector<double>* input : {&withNaN, &withInf}) {
+        for (size_t m = 0; m < 3; m++) {
+            GrubbsResult result = runGrubbs<double, GRUBBS_TWO_SIDED>(*input, kModes[m]);
+            CHECK_MSG(result.ret == -1, "%s returned %d on non-finite input", kModeNames[m],
+                      result.ret);
+        }
+        checkModesAgree<double, GRUBBS_TWO_SIDED>(*input, "non-finite");
+        checkModesAgree<double, GRUBBS_UPPER>(*input, "non-finite");
+
+        std::vector<double> copy = *input;
+        size_t cleanSize;
+        CHECK(performGrubbsInPlace(copy.data(), copy.size(), 0.05, &cleanSize, nullptr, nullptr,
+                                   nullptr, GRUBBS_MODE_SORTED) == -1);
+    }
+}
+
+// Integer and float input is read in place but must behave exactly as if it had
+// been converted to double first
+template <typename T, GrubbsTail tail>
+static void checkMatchesDouble(const std::vector<T>& values, const char* label) {
+    std::vector<double> converted(values.begin(), values.end());
+    for (size_t m = 0; m < 3; m++) {
+        GrubbsResult typed = runGrubbs<T, tail>(values, kModes[m]);
+        GrubbsResult reference = runGrubbs<double, tail>(converted, kModes[m]);
+        CHECK_MSG(reference.ret == 0 && sameResult(typed, reference),
+                  "%s n=%zu tail=%d %s: ret %d vs %d", label, values.size(), (int)tail,
+                  kModeNames[m], typed.ret, reference.ret);
+    }
+}
+
+template <GrubbsTail tail>
+static void checkTypes(size_t size, double fraction, uint64_t seed) {
+    std::vector<double> data = makeData(size, fraction, false, seed);
+    std::vector<int32_t> ints(size);
+    std::vector<int64_t> longs(size);
+    // Residuals are compared to G unscaled, so keep unit steps: wider integer
+    // spreads would cascade every run down to n = 2. The int64 offset checks
+    // large magnitudes that are still exact in double.
+    for (size_t i = 0; i < size; i++) {
+        ints[i] = (int32_t)std::lround(data[i]);
+        longs[i] = (int64_t(1) << 40) + std::llround(data[i]);
+    }
+    std::vector<float> floats(data.begin(), data.end());
+    checkMatchesDouble<int32_t, tail>(ints, "int32");
+    checkMatchesDouble<int64_t, tail>(longs, "int64");
+    checkMatchesDouble<float, tail>(floats, "float");
+}
+
+GRUBBS_TEST(typedInputMatchesConvertedDouble) {
+    // The large size runs the pool-split passes; few outliers keep scan mode quick
+    for (size_t size : {size_t(20), size_t(1000), kParallelMinSize + 777}) {
+        double fraction = size > 1000 ? 1e-5 : 0.02;
+        checkTypes<GRUBBS_TWO_SIDED>(size, fraction, size + 1);
+        checkTypes<GRUBBS_UPPER>(size, fraction, size + 2);
+        checkTypes<GRUBBS_LOWER>(size, fraction, size + 3);
+    }
+}
+
+// One-sided tests only ever remove their own tail, and put all of alpha in it:
+// a point between the one-sided and two-sided critical values is removed by its
+// own tail only, and one just short of the one-sided value by neither
+GRUBBS_TEST(oneSidedTailsUseTheirOwnTail) {
+    const size_t n = 30;
+    double twoSided = grubbsCriticalValue(0.05, n);
+    double oneSided = grubbsCriticalValue(0.10, n);
+    double looser = grubbsCriticalValue(0.20, n);
+    CHECK(looser < oneSided && oneSided < twoSided);
+
+    // 29 points evenly spread around 0, plus x: x's residual is (n - 1) / n * x
+    for (double residual : {(oneSided + twoSided) / 2, (looser + oneSided) / 2}) {
+        bool removed = residual > oneSided;
+        for (double sign : {1.0, -1.0}) {
+            std::vector<double> values;
+            for (size_t k = 0; k + 1 < n; k++) values.push_back(-1.0 + 2.0 * k / (n - 2));
+            values.push_back(sign * residual * n / (n - 1));
+
+            GrubbsResult upper = runGrubbs<double, GRUBBS_UPPER>(values, GRUBBS_MODE_AUTO);
+            GrubbsResult lower = runGrubbs<double, GRUBBS_LOWER>(values, GRUBBS_MODE_AUTO);
+            GrubbsResult both = runGrubbs<double, GRUBBS_TWO_SIDED>(values, GRUBBS_MODE_AUTO);
+            size_t upperCount = 0, lowerCount = 0, bothCount = 0;
+            for (size_t i = 0; i < n; i++) {
+                upperCount += upper.mask[i];
+                lowerCount += lower.mask[i];
+                bothCount += both.mask[i];
+            }
+            bool own = (sign > 0 ? upper.mask : lower.mask)[n - 1];
+            CHECK_MSG(upper.ret == 0 && lower.ret == 0 && both.ret == 0 &&
+                      own == removed && upperCount + lowerCount == (size_t)removed &&
+                      bothCount == 0,
+                      "residual %.4f sign %+.0f: upper %zu, lower %zu, two-sided %zu removed",
+                      residual, sign, upperCount, lowerCount, bothCount);
+        }
+    }
+
+    // Contaminated on both sides: each tail takes exactly its own far points
+    std::vector<double> data = makeData(5000, 0.02, false, 47);
+    GrubbsResult upper = runGrubbs<double, GRUBBS_UPPER>(data, GRUBBS_MODE_AUTO);
+    GrubbsResult lower = runGrubbs<double, GRUBBS_LOWER>(data, GRUBBS_MODE_AUTO);
+    size_t wrong = 0;
+    for (size_t i = 0; i < data.size(); i++) {
+        wrong += upper.mask[i] != (data[i] > 40.0);
+        wrong += lower.mask[i] != (data[i] < -40.0);
+    }
+    CHECK_MSG(upper.ret == 0 && lower.ret == 0 && wrong == 0,
+              "ret %d / %d, %zu points in the wrong tail", upper.ret, lower.ret, wrong);
+}
@@ -0,0 +1,216 @@
+#include "testUtil.hpp"
+#include "simdKernels.hpp"
+#include <cmath>
+#include <cstdint>
+#include <random>
+#include <vector>
+
+static const SimdLevel kLevels[] = {SIMD_SCALAR, SIMD_AVX2, SIMD_AVX512};
+static const char* kLevelNames[] = {"scalar", "avx2", "avx512"};
+
+// Sizes around the 4/8-lane vector widths and the 512-element blocks
+static const size_t kSizes[] = {1, 2, 3, 7, 8, 9, 511, 512, 513, 1025, 4099, 100003};
+
+static const double kEpsilon = 2.220446049250313e-16;
+
+// Mean: 16 ulps of the data's scale. M2: 64 ulps per unit of condition number.
+static const double kMeanTolerance = 16 * kEpsilon;
+static const double kM2Tolerance = 64 * kEpsilon;
+// z-scores: a multiply by the reciprocal of sd, so a few ulps of the result
+static const double kZScoreTolerance = 4 * kEpsilon;
+
+// Runs fn at every level the CPU supports, then restores the detected level
+template <typename Fn>
+static void forEachLevel(Fn&& fn) {
+    for (SimdLevel level : kLevels) {
+        setSimdLevel(level);
+        if (activeSimdLevel() != level) {
+            std::printf("  %s not supported, skipped\n", kLevelNames[level]);
+            continue;
+        }
+        fn(level);
+    }
+    setSimdLevel(detectSimdLevel());
+}
+
+// Normal data around offset, stored as T the way a caller's array would be
+template <typename T>
+static std::vector<T> makeValues(size_t size, double offset, double sd, uint64_t seed) {
+    std::mt19937_64 rng(seed);
+    std::normal_distribution<double> normal(offset, sd);
+    std::vector<T> values(size);
+    for (T& x : values) x = (T)normal(rng);
+    return values;
+}
+
+// Two-pass mean and M2 in long double over the values as the kernels see them
+template <typename T>
+static void referenceMeanM2(const std::vector<T>& values, long double* mean, long double* M2) {
+    long double sum = 0;
+    for (T x : values) sum += (double)x;
+    *mean = sum / values.size();
+    long double m2 = 0;
+    for (T x : values) {
+        long double d = (double)x - *mean;
+        m2 += d * d;
+    }
+    *M2 = m2;
+}
+
+template <typename T>
+static void checkMeanM2(const char* typeName, double offset, double sd) {
+    forEachLevel([&](SimdLevel level) {
+        for (size_t size : kSizes) {
+            std::vector<T> values = makeValues<T>(size, offset, sd, size * 31 + level);
+            long double refMean, refM2;
+            referenceMeanM2(values, &refMean, &refM2);
+
+            double mean, M2;
+            kernelMeanM2(values.data(), size, &mean, &M2);
+            // Mean error relative to the data's scale. M2 error relative to M2,
+            // allowed to grow with the condition number |mean| / sd: inputs far
+            // from zero only carry that much precision about their spread.
+            long double refSd = std::sqrt(refM2 / size);
+            long double scale = std::fabs(refMean) + refSd + 1;
+            double meanErr = (double)(std::fabs(mean - refMean) / scale);
+            double m2Err = refM2 > 0 ? (double)(std::fabs(M2 - refM2) / refM2) : std::fabs(M2);
+            double m2Tolerance = refM2 > 0 ? (double)(kM2Tolerance * (1 + std::fabs(refMean) / refSd))
+                                           : 0.0;
+            CHECK_MSG(meanErr <= kMeanTolerance && m2Err <= m2Tolerance,
+                      "%s %s n=%zu offset=%g: mean error %.3g, M2 error %.3g",
+                      kLevelNames[level], typeName, size, offset, meanErr, m2Err);
+        }
+    });
+}
+
+GRUBBS_TEST(meanM2MatchesReference) {
+    for (double offset : {0.0, -5e3, 1e9}) {
+        checkMeanM2<double>("double", offset, 3.0);
+        checkMeanM2<float>("float", offset, 3.0);
+    }
+    checkMeanM2<int32_t>("int32", 0.0, 1000.0);
+    checkMeanM2<int32_t>("int32", 2e9, 1e6);
+    checkMeanM2<int64_t>("int64", 0.0, 1000.0);
+    checkMeanM2<int64_t>("int64", 1e15, 1e6);
+}
+
+// Index of the first largest |x - mean| and whether another element ties it
+template <typename T>
+static size_t referenceArgmax(const std::vector<T>& values, double mean, double* maxRes,
+                              bool* tied) {
+    size_t best = 0;
+    *maxRes = std::fabs((double)values[0] - mean);
+    *tied = false;
+    for (size_t i = 1; i < values.size(); i++) {
+        double r = std::fabs((double)values[i] - mean);
+        if (r > *maxRes) {
+            *maxRes = r;
+            best = i;
+            *tied = false;
+        } else if (r == *maxRes) {
+            *tied = true;
+        }
+    }
+    return best;
+}
+
+template <typename T>
+static void checkArgmax(const char* typeName, const std::vector<T>& values, double mean,
+                        const char* label) {
+    double refRes;
+    bool refTied;
+    size_t refIndex = referenceArgmax(values, mean, &refRes, &refTied);
+    forEachLevel([&](SimdLevel level) {
+        double maxRes;
+        bool tied;
+        size_t index = kernelArgmaxResidual(values.data(), values.size(), mean, &maxRes, &tied);
+        CHECK_MSG(index == refIndex && maxRes == refRes && tied == refTied,
+                  "%s %s %s n=%zu: got (%zu, %.17g, %d), expected (%zu, %.17g, %d)",
+                  kLevelNames[level], typeName, label, values.size(), index, maxRes, (int)tied,
+                  refIndex, refRes, (int)refTied);
+    });
+}
+
+template <typename T>
+static void checkArgmaxCases(const char* typeName) {
+    for (size_t size : kSizes) {
+        std::vector<T> values = makeValues<T>(size, 100.0, 20.0, size + 7);
+        checkArgmax(typeName, values, 100.5, "random");
+        if (size < 3) continue;
+
+        // Equal residuals on opposite sides of the mean, in different lanes and blocks
+        std::vector<T> tiedValues = values;
+        size_t first = size / 3, second = size - 1;
+        tiedValues[first] = (T)500;
+        tiedValues[second] = (T)-300;
+        checkArgmax(typeName, tiedValues, 100.0, "tie across sides");
+
+        // The same extreme value twice: the first index must win
+        tiedValues[second] = (T)500;
+        checkArgmax(typeName, tiedValues, 100.0, "repeated maximum");
+
+        // A single extreme at the very end, past the last full vector
+        std::vector<T> lastValues = values;
+        lastValues[size - 1] = (T)900;
+        checkArgmax(typeName, lastValues, 100.0, "last element");
+    }
+}
+
+GRUBBS_TEST(argmaxResidualFirstIndexAndTies) {
+    checkArgmaxCases<double>("double");
+    checkArgmaxCases<float>("float");
+    checkArgmaxCases<int32_t>("int32");
+    checkArgmaxCases<int64_t>("int64");
+
+    // int64 lanes beyond 2^32 exercise the widening load
+    std::vector<int64_t> wide = makeValues<int64_t>(1027, 0.0, 1e12, 5);
+    wide[600] = (int64_t)1 << 52;
+    checkArgmax("int64", wide, 0.0, "wide values");
+}
+
+template <typename T>
+static void checkZScores(const char* typeName, double offset, double sd) {
+    forEachLevel([&](SimdLevel level) {
+        for (size_t size : kSizes) {
+            std::vector<T> values = makeValues<T>(size, offset, sd, size + 11);
+            double mean = offset + 0.25, scale = sd * 1.5;
+            std::vector<double> zscores(size);
+            kernelZScores(values.data(), size, mean, scale, zscores.data());
+
+            double worst = 0.0;
+            for (size_t i = 0; i < size; i++) {
+                long double expected = ((long double)(double)values[i] - mean) / scale;
+                double err = (double)(std::fabs(zscores[i] - expected) /
+                                      std::fmax(1.0L, std::fabs(expected)));
+                worst = std::fmax(worst, err);
+            }
+            CHECK_MSG(worst <= kZScoreTolerance, "%s %s n=%zu: worst z-score error %.3g",
+                      kLevelNames[level], typeName, size, worst);
+        }
+    });
+}
+
+GRUBBS_TEST(zScoresMatchReference) {
+    checkZScores<double>("double", 0.0, 1.0);
+    checkZScores<double>("double", 1e6, 50.0);
+    checkZScores<float>("float", 10.0, 3.0);
+    checkZScores<int32_t>("int32", 0.0, 1000.0);
+    checkZScores<int64_t>("int64", 1e12, 1e6);
+}
+
+// Every level must agree with the scalar path on the same input
+GRUBBS_TEST(levelsAgreeWithScalar) {
+    std::vector<double> values = makeValues<double>(100003, 42.0, 7.0, 99);
+    setSimdLevel(SIMD_SCALAR);
+    double scalarMean, scalarM2;
+    kernelMeanM2(values.data(), values.size(), &scalarMean, &scalarM2);
+
+    forEachLevel([&](SimdLevel level) {
+        double mean, M2;
+        kernelMeanM2(values.data(), values.size(), &mean, &M2);
+        CHECK_MSG(std::fabs(mean - scalarMean) <= kMeanTolerance * std::fabs(scalarMean) &&
+                  std::fabs(M2 - scalarM2) <= kM2Tolerance * scalarM2,
+                  "%s: mean %.17g vs %.17g, M2 %.17g vs %.17g", kLevelNames[level],
+                  mean, scalarMean, M2, scalarM2);
+    });
+}
@@ -0,0 +1,80 @@
+#include "testUtil.hpp"
+#include "streamingGrubbs.hpp"
+#include "mainFunctions.hpp"
+#include <algorithm>
+#include <cmath>
+#include <cstring>
+#include <limits>
+#include <random>
+#include <vector>
+
+// Gaps (NaN / infinity) in a stream must be skipped without disturbing the
+// window: the finite points score exactly as in a stream without the gaps.
+GRUBBS_TEST(streamSkipsNonFiniteValues) {
+    const double nan = std::numeric_limits<double>::quiet_NaN();
+    const double inf = std::numeric_limits<double>::infinity();
+    std::mt19937_64 rng(17);
+    std::normal_distribution<double> normal(0.0, 1.0);
+
+    GrubbsStream withGaps(100), clean(100);
+    size_t finiteCount = 0, skipped = 0, mismatched = 0;
+    for (size_t i = 0; i < 5000; i++) {
+        double zscore;
+        bool isOutlier;
+        if (i % 7 == 3) {
+            int ret = withGaps.push((i % 14 == 3) ? nan : inf, &zscore, &isOutlier);
+            if (ret == -1 && std::isnan(zscore) && !isOutlier) skipped++;
+            continue;
+        }
+        // Occasional far points so the removal loop has work to do
+        double value = (i % 97 == 0) ? 80.0 : normal(rng);
+        double expectedZ, z;
+        bool expectedOutlier;
+        int expectedRet = clean.push(value, &expectedZ, &expectedOutlier);
+        int ret = withGaps.push(value, &z, &isOutlier);
+        finiteCount++;
+        if (ret != expectedRet || isOutlier != expectedOutlier ||
+            std::memcmp(&z, &expectedZ, sizeof(double))) {
+            mismatched++;
+        }
+    }
+    CHECK_MSG(mismatched == 0, "%zu of %zu finite pushes differ", mismatched, finiteCount);
+    CHECK_MSG(skipped == 5000 - finiteCount, "%zu gaps skipped", skipped);
+    CHECK(withGaps.size() == 100);
+    CHECK(withGaps.mean() == clean.mean() && withGaps.stdDev() == clean.stdDev());
+}
+
+// Each push must agree with a full sorted-mode run over the same window: same
+// verdict for the new point and the same z-score up to the rounding of the
+// running statistics.
+GRUBBS_TEST(streamMatchesFullRunOverWindow) {
+    const size_t capacity = 200;
+    std::vector<double> data = makeContaminatedData(4000, 0.03, 43);
+    GrubbsStream stream(capacity);
+    std::vector<double> window, zscores(capacity);
+    std::vector<unsigned char> mask(capacity);
+    size_t compared = 0, outliers = 0, mismatched = 0;
+    double worst = 0.0;
+    for (size_t i = 0; i < data.size(); i++) {
+        double z;
+        bool isOutlier;
+        int ret = stream.push(data[i], &z, &isOutlier);
+        window.push_back(data[i]);
+        if (window.size() > capacity) window.erase(window.begin());
+        if (window.size() < capacity) continue;
+
+        int expectedRet = performGrubbs(window.data(), window.size(), zscores.data(), 0.05,
+                                        mask.data(), nullptr, nullptr, GRUBBS_MODE_SORTED);
+        double expectedZ = zscores.back();
+        double diff = std::fabs(z - expectedZ) / std::max(1.0, std::fabs(expectedZ));
+        worst = std::max(worst, diff);
+        compared++;
+        outliers += mask.back();
+        if (ret != expectedRet || isOutlier != (mask.back() != 0) || !(diff <= 1e-9)) {
+            mismatched++;
+        }
+    }
+    CHECK_MSG(mismatched == 0, "%zu of %zu pushes differ, worst z-score difference %.3g",
+              mismatched, compared, worst);
+    CHECK_MSG(outliers > 50, "only %zu new points were outliers", outliers);
+}
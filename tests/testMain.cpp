@@ -0,0 +1,49 @@
+// Native tests of the C++ core, run by ctest. Each *Test.cpp registers its
+// cases with GRUBBS_TEST; `grubbstests [name...]` runs all or the named ones.
+
+#include "testUtil.hpp"
+#include <cstdio>
+#include <cstring>
+#include <vector>
+
+struct TestCase {
+    const char* name;
+    TestFn fn;
+};
+
+static std::vector<TestCase>& testCases() {
+    static std::vector<TestCase> cases;
+    return cases;
+}
+
+TestRegistrar::TestRegistrar(const char* name, TestFn fn) {
+    testCases().push_back({name, fn});
+}
+
+int& testFailures() {
+    static int failures = 0;
+    return failures;
+}
+
+static bool selected(const char* name, int argc, char** argv) {
+    if (argc < 2) return true;
+    for (int i = 1; i < argc; i++) {
+        if (!std::strcmp(argv[i], name)) return true;
+    }
+    return false;
+}
+
+int main(int argc, char** argv) {
+    size_t failedCases = 0, ran = 0;
+    for (const TestCase& test : testCases()) {
+        if (!selected(test.name, argc, argv)) continue;
+        int before = testFailures();
+        test.fn();
+        ran++;
+        bool ok = testFailures() == before;
+        if (!ok) failedCases++;
+        std::printf("[%s] %s\n", ok ? "  OK  " : " FAIL ", test.name);
+    }
+    std::printf("%zu of %zu tests passed\n", ran - failedCases, ran);
+    return failedCases ? 1 : 0;
+}
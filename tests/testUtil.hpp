@@ -0,0 +1,65 @@
+#ifndef TESTUTIL_H
+#define TESTUTIL_H
+
+#include <cstddef>
+#include <cstdint>
+#include <cstdio>
+#include <random>
+#include <vector>
+
+// Minimal self-registering checks for the grubbstests executable. A test is a
+// function declared with GRUBBS_TEST; CHECK records a failure and keeps going.
+
+typedef void (*TestFn)();
+
+struct TestRegistrar {
+    TestRegistrar(const char* name, TestFn fn);
+};
+
+// Number of failed CHECKs so far
+int& testFailures();
+
+#define GRUBBS_TEST(name)                                       \
+    static void name();                                         \
+    static TestRegistrar name##Registrar(#name, name);          \
+    static void name()
+
+#define CHECK(cond)                                                             \
+    do {                                                                        \
+        if (!(cond)) {                                                          \
+            std::fprintf(stderr, "%s:%d: CHECK(%s) failed\n", __FILE__, __LINE__, #cond); \
+            testFailures()++;                                                   \
+        }                                                                       \
+    } while (0)
+
+// Like CHECK, with the printf-style message appended to the failure line
+#define CHECK_MSG(cond, ...)                                                    \
+    do {                                                                        \
+        if (!(cond)) {                                                          \
+            std::fprintf(stderr, "%s:%d: CHECK(%s) failed: ", __FILE__, __LINE__, #cond); \
+            std::fprintf(stderr, __VA_ARGS__);                                  \
+            std::fprintf(stderr, "\n");                                         \
+            testFailures()++;                                                   \
+        }                                                                       \
+    } while (0)
+
+// Standard normal data with `fraction` of the points moved 50-100 out, on either
+// side. The test compares raw residuals against G, which reaches ~30 at 10M, so
+// closer points would not be removed at large sizes and would cascade to n = 2
+// at small ones. Shared by the tests and grubbsbench.
+inline std::vector<double> makeContaminatedData(size_t size, double fraction, uint64_t seed) {
+    std::mt19937_64 rng(seed);
+    std::normal_distribution<double> normal(0.0, 1.0);
+    std::uniform_real_distribution<double> shift(50.0, 100.0);
+    std::vector<double> values(size);
+    for (double& x : values) x = normal(rng);
+
+    size_t outliers = (size_t)(fraction * size);
+    for (size_t k = 0; k < outliers; k++) {
+        size_t i = rng() % size;
+        values[i] = (rng() & 1) ? shift(rng) : -shift(rng);
+    }
+    return values;
+}
+
+#endif // TESTUTIL_H